@@ -0,0 +1,119 @@
+﻿#pragma once
+
+#include <atomic>
+#include "Platform.h"
+
+// 지수 백오프의 처음/최대 대기 횟수 (PoolCpuRelax 호출 수)
+#define BACKOFF_MIN_SPIN 4
+#define BACKOFF_MAX_SPIN 1024
+
+// 제거(elimination) 배열의 슬롯 수와, Push가 슬롯에 노드를 내놓고 Pop을 기다리는 횟수
+#define ELIMINATION_SLOT_COUNT 8
+#define ELIMINATION_SPIN_COUNT 128
+
+
+// 스레드별 xorshift 난수. 백오프 길이와 슬롯 선택을 스레드마다 흩뜨리는 용도
+inline UINT32 PoolThreadRandom(void)
+{
+    thread_local UINT32 t_state = 0;
+    if (t_state == 0)
+    {
+        static std::atomic<UINT32> s_seed{ 0x9E3779B9 };
+        t_state = s_seed.fetch_add(0x9E3779B9, std::memory_order_relaxed) | 1;
+    }
+
+    t_state ^= t_state << 13;
+    t_state ^= t_state >> 17;
+    t_state ^= t_state << 5;
+    return t_state;
+}
+
+
+// CAS가 실패할 때마다 대기 시간을 두 배로 늘림
+// 여러 스레드가 같은 캐시 라인을 두고 동시에 재시도하지 않도록 대기 횟수는 [limit/2, limit) 에서 무작위로 고름
+class ExponentialBackoff
+{
+public:
+    void Pause(void)
+    {
+        UINT32 spin = (m_limit >> 1) + (PoolThreadRandom() & ((m_limit >> 1) - 1));
+        for (UINT32 i = 0; i < spin; i++)
+        {
+            PoolCpuRelax();
+        }
+
+        if (m_limit < BACKOFF_MAX_SPIN)
+            m_limit <<= 1;
+    }
+
+    void Reset(void) { m_limit = BACKOFF_MIN_SPIN; }
+
+private:
+    UINT32 m_limit = BACKOFF_MIN_SPIN;
+};
+
+
+// 제거 배열 (elimination backoff)
+// top CAS에 실패한 Push와 Pop이 여기서 만나면 top을 건드리지 않고 노드를 직접 주고받음
+// 스택에서는 Push 직후 Pop한 것과 같으므로 결과가 달라지지 않음
+// 슬롯 값 : 0 = 비어 있음, TAKEN = Pop이 가져감, 그 외 = Push가 내놓은 노드 주소
+template<typename NodeType>
+class EliminationArray
+{
+public:
+    // Push 쪽. node를 빈 슬롯에 내놓고 잠시 기다림
+    // Pop이 가져갔다면 true (Push 완료), 아무도 가져가지 않았다면 node를 회수하고 false
+    bool TryPush(NodeType* node)
+    {
+        Slot& slot = m_slots[PoolThreadRandom() % ELIMINATION_SLOT_COUNT];
+
+        uintptr_t expected = 0;
+        if (!slot.value.compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(node), std::memory_order_release, std::memory_order_relaxed))
+            return false; // 다른 스레드가 쓰는 중
+
+        for (UINT32 i = 0; i < ELIMINATION_SPIN_COUNT; i++)
+        {
+            if (slot.value.load(std::memory_order_acquire) == TAKEN)
+            {
+                slot.value.store(0, std::memory_order_release);
+                return true;
+            }
+            PoolCpuRelax();
+        }
+
+        // 기다리는 동안 아무도 가져가지 않았다면 회수. 회수에 실패했다면 그 사이에 가져간 것
+        expected = reinterpret_cast<uintptr_t>(node);
+        if (slot.value.compare_exchange_strong(expected, 0, std::memory_order_acquire, std::memory_order_acquire))
+            return false;
+
+        slot.value.store(0, std::memory_order_release);
+        return true;
+    }
+
+    // Pop 쪽. 슬롯 하나를 보고 Push가 내놓은 노드가 있다면 가져옴. 없다면 nullptr
+    // 가져간 노드는 스택에 들어간 적이 없으므로 다른 스레드가 읽고 있지 않음
+    NodeType* TryPop(void)
+    {
+        Slot& slot = m_slots[PoolThreadRandom() % ELIMINATION_SLOT_COUNT];
+
+        uintptr_t value = slot.value.load(std::memory_order_acquire);
+        if (value == 0 || value == TAKEN)
+            return nullptr;
+
+        if (!slot.value.compare_exchange_strong(value, TAKEN, std::memory_order_acq_rel, std::memory_order_relaxed))
+            return nullptr;
+
+        return reinterpret_cast<NodeType*>(value);
+    }
+
+private:
+    static constexpr uintptr_t TAKEN = 1;
+
+    // 슬롯끼리 false sharing이 나지 않도록 캐시 라인마다 하나
+    struct alignas(CACHE_LINE_SIZE) Slot
+    {
+        std::atomic<uintptr_t> value{ 0 };
+    };
+
+    Slot m_slots[ELIMINATION_SLOT_COUNT];
+};
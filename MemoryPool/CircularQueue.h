@@ -2,30 +2,32 @@
 
 #define CQSIZE 20000
 
-#include <Windows.h>
+#include "Platform.h"
 
+// 디버그 기록용 덮어쓰기 링. 여러 스레드가 enqueue만 하고, 꺼내는 것은 멈춘 상태에서 디버거로 확인할 때뿐임
+// 스레드 간에 원소를 넘기는 용도라면 MPMCQueue.h 의 MPMCQueue를 사용
 template <typename T>
 class CircularQueue {
 public:
-    // 
-    CircularQueue(UINT32 size = CQSIZE) : capacity(size), count(0) {
-        //queue = new T[capacity];  //  迭 Ҵ
+    // 생성자
+    CircularQueue(UINT32 size = CQSIZE) : count(0), capacity(size) {
+        //queue = new T[capacity];  // 동적 배열 할당
     }
 
-    // Ҹ
+    // 소멸자
     ~CircularQueue() {
-        //delete[] queue;  //  迭 
+        //delete[] queue;  // 동적 배열 해제
     }
 
-    // ť  ߰ (enqueue)
+    // 큐에 데이터 추가 (enqueue)
     void enqueue(const T& data) {
-        UINT32 inc = InterlockedIncrement(&count);
+        UINT32 inc = count.fetch_add(1, std::memory_order_relaxed) + 1;
 
-        UINT32 index = inc % capacity;  //  迭 ó
+        UINT32 index = inc % capacity;  // 원형 배열 처리
         queue[index] = data;
     }
 
-    //    ϰ Ϸ ϴ Լ. ÿ  .   Ȳ ϱ ϶ .
+    // 내용을 출력할 때 편하게 하려고 사용하는 함수. 평상시엔 사용하지 않음. 오로지 디버그 상황에서 출력하기 편하라도 사용.
     const T& dequeue(void)
     {
         if (!bDequeue)
@@ -40,13 +42,13 @@ public:
         return queue[(deqeueCnt + 1) % capacity];
     }
 
-    UINT32 GetCount(void) { return count; }
+    UINT32 GetCount(void) { return count.load(std::memory_order_relaxed); }
 
 private:
-    T queue[CQSIZE];           // ť 迭
+    T queue[CQSIZE];           // 큐 배열
 
-    UINT32 count;
-    UINT32 capacity;    // ť ִ ũ
+    std::atomic<UINT32> count;
+    UINT32 capacity;    // 큐의 최대 크기
 
     bool bDequeue = false;
     int deqeueCnt = -1;
@@ -0,0 +1,296 @@
+﻿#pragma once
+
+#include <atomic>
+#include <vector>
+#include <thread>
+#include "Platform.h"
+
+// 스레드가 이만큼 retire할 때마다 전역 epoch를 올리고 안전해진 것을 해제해 봄
+#define EPOCH_COLLECT_PERIOD 64
+
+// 보호 구간 밖에 있는 스레드의 epoch 값
+#define EPOCH_INACTIVE UINT64_MAX
+
+
+// epoch 기반 메모리 회수 (EBR)
+// lock-free 자료구조에서 떼어낸 노드를 다른 스레드가 아직 읽고 있을 수 있어서 바로 delete/unmap할 수 없을 때 사용
+//
+// 읽는 쪽 : 공유 포인터를 따라가는 동안 EpochGuard로 보호 구간에 들어가 있음
+// 지우는 쪽 : 자료구조에서 떼어낸 뒤 Retire로 넘김. 그때의 전역 epoch를 함께 기록
+// 전역 epoch는 보호 구간에 있는 모든 스레드가 현재 epoch를 본 뒤에만 1 올라감
+// 따라서 epoch가 기록한 값보다 2 이상 올라갔다면, 떼어내기 전에 들어와 있던 스레드는 모두 빠져나간 상태이므로 해제해도 안전함
+//
+// 스레드 레코드는 한 번 만들면 해제하지 않고, 스레드가 끝나면 다음 스레드가 이어받음 (아직 해제하지 못한 목록도 함께)
+class EpochReclaimer
+{
+public:
+    // ptr을 해제하는 함수. arg는 Retire에 넘긴 값 그대로 (크기 등)
+    using Deleter = void (*)(void* ptr, size_t arg);
+
+    // 보호 구간 진입/탈출. 중첩해서 호출해도 됨
+    static void Enter(void);
+    static void Leave(void);
+
+    // 공유 자료구조에서 이미 떼어낸 ptr을, 지금 보호 구간에 있는 스레드가 모두 빠져나간 뒤에 deleter(ptr, arg)로 해제
+    static void Retire(void* ptr, Deleter deleter, size_t arg = 0);
+
+    // 가능하다면 전역 epoch를 올리고, 이 스레드가 retire한 것 중 안전해진 것을 해제. 해제한 갯수를 반환
+    static size_t Collect(void);
+
+    // 이 스레드가 retire한 것을 모두 해제할 때까지 Collect를 반복 (종료 시점이나 테스트용)
+    // 다른 스레드가 보호 구간에 오래 머물러 있다면 그동안 기다림
+    static void Drain(void);
+
+public:
+    static UINT64 GetEpoch(void) { return State().globalEpoch.load(std::memory_order_acquire); }
+
+    // 지금까지 retire/해제된 전체 갯수
+    static UINT64 GetRetiredCount(void) { return State().retiredCount.load(std::memory_order_relaxed); }
+    static UINT64 GetReclaimedCount(void) { return State().reclaimedCount.load(std::memory_order_relaxed); }
+
+private:
+    struct RetiredEntry
+    {
+        void* ptr;
+        Deleter deleter;
+        size_t arg;
+        UINT64 epoch;   // retire할 때의 전역 epoch
+    };
+
+    // 스레드 하나의 상태. epoch는 다른 스레드가 자주 읽으므로 캐시 라인을 따로 씀
+    struct alignas(CACHE_LINE_SIZE) ThreadRecord
+    {
+        std::atomic<UINT64> epoch{ EPOCH_INACTIVE };    // 보호 구간에서 본 전역 epoch
+        std::atomic<bool> bInUse{ true };               // 스레드가 사용 중인지
+        ThreadRecord* next = nullptr;                   // 레코드 목록. 추가만 하므로 락 없이 훑을 수 있음
+
+        UINT32 nesting = 0;             // 보호 구간 중첩 깊이 (주인 스레드만 접근)
+        UINT32 retireTick = 0;
+        bool bReclaiming = false;       // deleter를 호출하는 중인지 (주인 스레드만 접근)
+        std::vector<RetiredEntry> limbo; // 아직 해제하지 못한 목록 (epoch 순)
+    };
+
+    struct ReclaimerState
+    {
+        alignas(CACHE_LINE_SIZE) std::atomic<UINT64> globalEpoch{ 0 };
+        alignas(CACHE_LINE_SIZE) std::atomic<ThreadRecord*> recordList{ nullptr };
+        std::atomic<UINT64> retiredCount{ 0 };
+        std::atomic<UINT64> reclaimedCount{ 0 };
+    };
+
+    // 정적 객체 소멸 순서에 휘말리지 않도록 일부러 해제하지 않음
+    static ReclaimerState& State(void)
+    {
+        static ReclaimerState* state = new ReclaimerState;
+        return *state;
+    }
+
+    // 스레드가 끝날 때 레코드를 반납
+    struct RecordOwner
+    {
+        ~RecordOwner(void);
+    };
+
+    // 현재 스레드의 레코드. 없다면 반납된 레코드를 이어받거나 새로 만듦
+    static ThreadRecord* GetRecord(void);
+
+    // 모든 사용 중인 스레드가 현재 epoch를 보고 있다면 전역 epoch를 1 올림
+    static void TryAdvance(void);
+
+    // record의 목록 중 안전해진 것을 해제
+    static size_t Reclaim(ThreadRecord* record);
+
+    // 끝나가는 스레드가 보호 구간 밖에 있다면 레코드를 반납
+    static void ReleaseIfExiting(ThreadRecord* record);
+
+private:
+    static inline thread_local ThreadRecord* t_record = nullptr;
+    static inline thread_local bool t_bExiting = false;    // RecordOwner가 이미 소멸했는지
+};
+
+// 범위 동안 보호 구간에 머무름
+class EpochGuard
+{
+public:
+    EpochGuard(void) { EpochReclaimer::Enter(); }
+    ~EpochGuard(void) { EpochReclaimer::Leave(); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+
+inline EpochReclaimer::ThreadRecord* EpochReclaimer::GetRecord(void)
+{
+    if (t_record)
+        return t_record;
+
+    ReclaimerState& state = State();
+
+    // 주인 스레드가 끝난 레코드를 먼저 찾아서 이어받음
+    ThreadRecord* record = nullptr;
+    for (ThreadRecord* cur = state.recordList.load(std::memory_order_acquire); cur; cur = cur->next)
+    {
+        bool bInUse = false;
+        if (!cur->bInUse.load(std::memory_order_relaxed) && cur->bInUse.compare_exchange_strong(bInUse, true, std::memory_order_acquire))
+        {
+            record = cur;
+            break;
+        }
+    }
+
+    if (record == nullptr)
+    {
+        record = new ThreadRecord;
+        ThreadRecord* head = state.recordList.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!state.recordList.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    t_record = record;
+
+    // 스레드가 끝날 때 반납하도록 등록. 이미 소멸 단계라면 등록하지 않고 Leave에서 바로 반납
+    if (!t_bExiting)
+    {
+        static thread_local RecordOwner owner;
+        (void)owner;
+    }
+
+    return record;
+}
+
+inline EpochReclaimer::RecordOwner::~RecordOwner(void)
+{
+    t_bExiting = true;
+
+    ThreadRecord* record = t_record;
+    if (record == nullptr)
+        return;
+
+    // 다른 thread_local 소멸자가 아직 보호 구간에 있다면 그쪽 Leave에서 반납
+    ReleaseIfExiting(record);
+}
+
+inline void EpochReclaimer::ReleaseIfExiting(ThreadRecord* record)
+{
+    if (!t_bExiting || record->nesting != 0)
+        return;
+
+    // 해제하지 못한 목록은 레코드에 남겨 두고, 이어받은 스레드가 해제
+    TryAdvance();
+    Reclaim(record);
+    t_record = nullptr;
+    record->bInUse.store(false, std::memory_order_release);
+}
+
+inline void EpochReclaimer::Enter(void)
+{
+    ThreadRecord* record = GetRecord();
+    if (record->nesting++ != 0)
+        return;
+
+    // 전역 epoch를 기록한 뒤의 읽기가 기록보다 앞서지 않도록 전체 펜스
+    // 그 사이 전역 epoch가 올라갔더라도 더 오래된 값을 기록한 것이므로 안전한 쪽으로 틀림
+    record->epoch.store(State().globalEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+inline void EpochReclaimer::Leave(void)
+{
+    ThreadRecord* record = t_record;
+    if (--record->nesting != 0)
+        return;
+
+    record->epoch.store(EPOCH_INACTIVE, std::memory_order_release);
+
+    // RecordOwner가 이미 소멸한 스레드라면 여기서 반납
+    ReleaseIfExiting(record);
+}
+
+inline void EpochReclaimer::Retire(void* ptr, Deleter deleter, size_t arg)
+{
+    ReclaimerState& state = State();
+    ThreadRecord* record = GetRecord();
+
+    // 떼어낸 뒤의 epoch를 읽어야 하므로 전체 펜스
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    record->limbo.push_back(RetiredEntry{ ptr, deleter, arg, state.globalEpoch.load(std::memory_order_relaxed) });
+    state.retiredCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (++record->retireTick % EPOCH_COLLECT_PERIOD == 0)
+    {
+        Collect();
+    }
+
+    ReleaseIfExiting(record);
+}
+
+inline size_t EpochReclaimer::Collect(void)
+{
+    TryAdvance();
+    return Reclaim(GetRecord());
+}
+
+inline void EpochReclaimer::Drain(void)
+{
+    ThreadRecord* record = GetRecord();
+    while (!record->limbo.empty())
+    {
+        Collect();
+        if (!record->limbo.empty())
+            std::this_thread::yield();
+    }
+}
+
+inline void EpochReclaimer::TryAdvance(void)
+{
+    ReclaimerState& state = State();
+    UINT64 epoch = state.globalEpoch.load(std::memory_order_acquire);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (ThreadRecord* cur = state.recordList.load(std::memory_order_acquire); cur; cur = cur->next)
+    {
+        UINT64 observed = cur->epoch.load(std::memory_order_acquire);
+        if (observed != EPOCH_INACTIVE && observed != epoch)
+            return; // 아직 이전 epoch에 머물러 있는 스레드가 있음
+    }
+
+    state.globalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+}
+
+inline size_t EpochReclaimer::Reclaim(ThreadRecord* record)
+{
+    // deleter 안의 Retire가 Collect까지 이어지면 같은 레코드로 다시 들어옴
+    // 바깥에서 아직 호출하지 않은 항목을 안쪽에서 또 해제하고 지우게 되므로, 안쪽 호출은 아무것도 하지 않음
+    // 그 사이 Retire된 항목은 목록 뒤에 남아 다음 Collect에서 해제됨
+    if (record->bReclaiming)
+        return 0;
+
+    UINT64 epoch = State().globalEpoch.load(std::memory_order_acquire);
+
+    // 목록은 epoch 순이므로 앞에서부터 안전한 만큼 고름
+    size_t freed = 0;
+    while (freed < record->limbo.size() && record->limbo[freed].epoch + 2 <= epoch)
+    {
+        freed++;
+    }
+
+    if (freed == 0)
+        return 0;
+
+    // deleter 안에서 다시 Retire하면 목록 뒤에 붙으면서 재할당될 수 있으므로 항목을 복사해서 호출
+    // 해제할 때마다 임시 목록을 만들지 않으므로 자주 Retire하는 경로에서도 힙을 호출하지 않음
+    record->bReclaiming = true;
+    for (size_t i = 0; i < freed; i++)
+    {
+        RetiredEntry entry = record->limbo[i];
+        entry.deleter(entry.ptr, entry.arg);
+    }
+    record->bReclaiming = false;
+
+    record->limbo.erase(record->limbo.begin(), record->limbo.begin() + freed);
+
+    State().reclaimedCount.fetch_add(freed, std::memory_order_relaxed);
+    return freed;
+}
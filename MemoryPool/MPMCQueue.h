@@ -0,0 +1,221 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "Platform.h"
+#include "SlabArena.h"
+
+// 여러 스레드가 넣고 여러 스레드가 꺼내는 고정 크기 lock-free 큐 (Dmitry Vyukov의 bounded MPMC queue)
+// 칸마다 sequence를 두어 넣는 쪽과 꺼내는 쪽이 같은 칸을 차례대로 쓰도록 맞춤
+//   sequence == pos        : 비어 있음. enqueue 위치가 pos인 스레드가 쓸 차례
+//   sequence == pos + 1    : 찼음. dequeue 위치가 pos인 스레드가 꺼낼 차례
+//   꺼낸 뒤에는 pos + capacity 로 바꿔 한 바퀴 뒤의 enqueue에게 넘김
+// 위치는 CAS 한 번으로 차지하고, 데이터를 쓰거나 읽은 뒤 sequence를 release로 갱신해서 상대에게 알림
+// 가득 찼거나 비었다면 기다리지 않고 false를 반환하므로, 재시도나 대기는 호출하는 쪽에서 정함
+// CircularQueue(디버그 기록용 덮어쓰기 링)와 달리 넣은 값은 한 번씩 정확히 꺼내짐
+template <typename T>
+class MPMCQueue {
+public:
+    // capacity : 최대 원소 수. 2의 거듭제곱으로 올림 (최소 2)
+    // arena : 칸 배열을 잘라 올 아레나. nullptr이면 힙. 아레나는 큐보다 오래 살아야 함
+    explicit MPMCQueue(size_t capacity, SlabArena* arena = nullptr);
+    ~MPMCQueue();
+
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    // 큐에 데이터 추가. 가득 찼다면 false
+    bool try_enqueue(const T& data) { return try_emplace(data); }
+    bool try_enqueue(T&& data) { return try_emplace(std::move(data)); }
+
+    // 칸에 T를 args로 바로 생성. 가득 찼다면 false이며 args는 건드리지 않음
+    // 생성자가 예외를 던질 수 있다면 칸을 차지하기 전에 임시 객체로 만들어 두고 이동만 칸에서 함
+    // (차지한 칸의 sequence를 갱신하지 못하면 꺼내는 쪽이 그 칸에서 영원히 멈추기 때문)
+    // 이 경우 가득 찼을 때도 rvalue args는 이미 임시 객체로 옮겨졌을 수 있음
+    template <typename... Args>
+    bool try_emplace(Args&&... args);
+
+    // 큐에서 데이터를 꺼내 data로 옮김. 비어 있다면 false
+    // 옮기는 대입이 예외를 던지면 그 원소는 소멸되고 예외는 그대로 전달됨. 큐는 계속 쓸 수 있음
+    bool try_dequeue(T& data);
+
+    size_t capacity(void) const { return m_mask + 1; }
+
+    // 다른 스레드가 동시에 넣고 꺼내는 중이라면 근삿값
+    size_t size_approx(void) const;
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* Data(void) { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    static constexpr size_t CELL_ALIGN = (alignof(Cell) > CACHE_LINE_SIZE) ? alignof(Cell) : CACHE_LINE_SIZE;
+
+    static size_t RoundUpPowerOfTwo(size_t value);
+
+private:
+    Cell* m_cells;
+    size_t m_mask;          // capacity - 1
+    SlabArena* m_arena;     // 칸 배열을 잘라 온 아레나, nullptr이면 힙
+
+    // 넣는 쪽과 꺼내는 쪽이 서로의 위치 때문에 캐시 라인을 주고받지 않도록 분리
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_enqueuePos;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_dequeuePos;
+};
+
+template <typename T>
+inline size_t MPMCQueue<T>::RoundUpPowerOfTwo(size_t value)
+{
+    size_t result = 2;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+template <typename T>
+inline MPMCQueue<T>::MPMCQueue(size_t capacity, SlabArena* arena)
+    : m_mask(RoundUpPowerOfTwo(capacity) - 1), m_arena(arena), m_enqueuePos(0), m_dequeuePos(0)
+{
+    size_t bytes = sizeof(Cell) * (m_mask + 1);
+
+    void* memory = nullptr;
+    if (m_arena)
+        memory = m_arena->Allocate(bytes, CELL_ALIGN);
+    if (memory == nullptr)
+    {
+        // 아레나가 모자라다면 힙에서 받음. 소멸자가 구분할 수 있도록 아레나를 지움
+        m_arena = nullptr;
+        memory = ::operator new(bytes, std::align_val_t(CELL_ALIGN));
+    }
+
+    m_cells = static_cast<Cell*>(memory);
+    for (size_t i = 0; i <= m_mask; i++)
+        new (&m_cells[i].sequence) std::atomic<size_t>(i);
+}
+
+template <typename T>
+inline MPMCQueue<T>::~MPMCQueue()
+{
+    // 남아 있는 원소의 소멸자 호출. 소멸 시점에는 다른 스레드가 큐를 쓰지 않음
+    for (size_t pos = m_dequeuePos.load(std::memory_order_relaxed); pos != m_enqueuePos.load(std::memory_order_relaxed); pos++)
+    {
+        Cell& cell = m_cells[pos & m_mask];
+        if (cell.sequence.load(std::memory_order_acquire) == pos + 1)
+            cell.Data()->~T();
+    }
+
+    size_t bytes = sizeof(Cell) * (m_mask + 1);
+    if (m_arena)
+        m_arena->Release(m_cells, bytes);
+    else
+        ::operator delete(m_cells, std::align_val_t(CELL_ALIGN));
+}
+
+template <typename T>
+template <typename... Args>
+inline bool MPMCQueue<T>::try_emplace(Args&&... args)
+{
+    if constexpr (!std::is_nothrow_constructible_v<T, Args&&...>)
+    {
+        // 임시 객체 생성 중의 예외는 칸을 차지하기 전이므로 큐에 영향 없음
+        static_assert(std::is_nothrow_move_constructible_v<T>, "MPMCQueue: T must be nothrow move constructible when its construction can throw");
+        T temp(std::forward<Args>(args)...);
+        return try_emplace(std::move(temp));
+    }
+    else
+    {
+        Cell* cell;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (diff == 0)
+            {
+                // 이 칸이 비어 있으므로 위치를 차지해 봄. 실패하면 pos가 최신 위치로 갱신됨
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // 한 바퀴 전의 원소가 아직 꺼내지지 않았음 (가득 참)
+                return false;
+            }
+            else
+            {
+                // 다른 스레드가 이 위치를 먼저 가져감
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (cell->storage) T(std::forward<Args>(args)...);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+}
+
+template <typename T>
+inline bool MPMCQueue<T>::try_dequeue(T& data)
+{
+    Cell* cell;
+    size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        cell = &m_cells[pos & m_mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+        if (diff == 0)
+        {
+            if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // 아직 아무도 이 위치에 넣지 않았음 (비어 있음)
+            return false;
+        }
+        else
+        {
+            pos = m_dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    static_assert(std::is_nothrow_destructible_v<T>, "MPMCQueue: T must be nothrow destructible");
+
+    // 한 바퀴 뒤에 이 칸을 쓸 enqueue에게 넘김
+    // 옮기는 대입이 예외를 던져도 넘기지 않으면 이후 enqueue가 이 칸에서 영원히 막히므로, 소멸과 넘기기는 범위를 벗어날 때 함
+    struct CellRelease
+    {
+        Cell* cell;
+        size_t sequence;
+
+        ~CellRelease()
+        {
+            cell->Data()->~T();
+            cell->sequence.store(sequence, std::memory_order_release);
+        }
+    } release{ cell, pos + m_mask + 1 };
+
+    data = std::move(*cell->Data());
+    return true;
+}
+
+template <typename T>
+inline size_t MPMCQueue<T>::size_approx(void) const
+{
+    size_t enqueuePos = m_enqueuePos.load(std::memory_order_relaxed);
+    size_t dequeuePos = m_dequeuePos.load(std::memory_order_relaxed);
+    return (enqueuePos > dequeuePos) ? enqueuePos - dequeuePos : 0;
+}
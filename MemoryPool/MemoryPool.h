@@ -4,23 +4,95 @@
 #include <chrono>
 #include <vector>
 #include <new>
-#include <Windows.h>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <algorithm>
+#include <type_traits>
+
+#include "Platform.h"
+#include "ShardedCounter.h"
+#include "SlabArena.h"
+#include "NumaTopology.h"
+#include "EpochReclaimer.h"
+#include "Backoff.h"
+#include "PoolTrace.h"
 
 #define GUARD_VALUE 0xAAAABBBBCCCCDDDD
 
-// Node ü 
+// Node 구조체 정의
 
-#ifdef _DEBUG
-#pragma pack(1)
-#endif // _DEBUG
+// 침투형(intrusive) 노드 배치
+// MEMORYPOOL_INTRUSIVE_LAYOUT 을 정의하면 릴리즈 빌드에서 next 를 객체 저장 공간에 겹쳐 둠 (free list 에 있는 동안만 next 를 씀)
+// tlsNode 의 ownerPool 도 노드마다 두지 않고, 슬랩을 세그먼트 경계에 정렬해 두고 주소를 마스킹해서 세그먼트 헤더에서 찾음
+// 작은 타입은 노드 크기가 절반 이하로 줄어 캐시 라인 하나에 살아 있는 객체가 더 많이 들어감
+// 디버그 빌드는 가드와 풀 확인 값이 필요하므로 항상 기존 배치를 씀
+#if defined(MEMORYPOOL_INTRUSIVE_LAYOUT) && !defined(_DEBUG)
+#define POOL_INTRUSIVE_NODE 1
+#else
+#define POOL_INTRUSIVE_NODE 0
+#endif
+
+// 모든 객체를 캐시 라인 경계에 두는 옵션
+// 서로 다른 스레드가 쓰는 객체가 이웃해 있어도 같은 캐시 라인을 두고 경쟁(false sharing)하지 않도록 노드 간격을 캐시 라인 배수로 맞춤
+#ifdef MEMORYPOOL_CACHE_ALIGN_OBJECTS
+#define POOL_OBJECT_ALIGN CACHE_LINE_SIZE
+#else
+#define POOL_OBJECT_ALIGN 1
+#endif // MEMORYPOOL_CACHE_ALIGN_OBJECTS
 
+// 노드 안에서 data가 맞춰야 하는 정렬. alignas(64) 같은 over-aligned 타입은 타입의 정렬을 따름
+// 노드 구조체 자체도 이 정렬을 가지므로 sizeof(노드)가 그 배수가 되어, 슬랩 안에서 노드를 이어 붙여도 모든 data가 정렬됨
+template<typename T>
+constexpr size_t PoolNodeAlign = (alignof(T) > POOL_OBJECT_ALIGN) ? alignof(T) : POOL_OBJECT_ALIGN;
 
+// 풀에서는 메모리만 받고 생성/소멸은 호출하는 쪽이 직접 할 때 쓰는 T 크기의 저장 공간
+// 생성자가 아무것도 하지 않으므로 bPlacementNew = true 로 써도 Alloc/Free에 추가 비용이 없고, 침투형 배치에서도 쓸 수 있음
 template<typename T>
-struct Node
+struct PoolRawStorage
 {
-    // x64 ȯ濡 ɰ ؼ UINT64  
-#ifdef _DEBUG
+    alignas(T) unsigned char bytes[sizeof(T)];
+
+    PoolRawStorage() {}
+};
+
+#if POOL_INTRUSIVE_NODE
+
+// 사용 중일 때는 data, free list 에 있을 때는 next 로 쓰는 공간
+// 생성자/소멸자는 풀이 placement new 와 명시적 소멸자 호출로 직접 관리
+template<typename T>
+union Node
+{
+    alignas(PoolNodeAlign<T>) T data;
+    UINT64 next;
+
+    Node() {}
+    ~Node() {}
+};
+
+// 주인 풀은 노드가 아니라 노드가 속한 세그먼트의 헤더에 있음 (SegmentOf 참고)
+template<typename T>
+union tlsNode
+{
+    alignas(PoolNodeAlign<T>) T data;
+    UINT64 next;
+
+    tlsNode() {}
+    ~tlsNode() {}
+};
+
+#elif defined(_DEBUG)
 
+// 디버그 노드는 가드가 data 바로 앞뒤에 붙도록 1바이트 단위로 채움
+// 이 배치는 data를 8바이트보다 크게 정렬할 수 없으므로 그런 타입은 아래의 AlignedDebugNode를 씀
+#pragma pack(push, 1)
+
+template<typename T>
+struct PackedDebugNode
+{
+    // x64 환경에서 빌드될것을 고려해서 UINT64 형을 사용
     UINT64 BUFFER_GUARD_FRONT;
     T data;
     UINT64 BUFFER_GUARD_END;
@@ -28,579 +100,2272 @@ struct Node
     UINT64 next;
     //Node<T>* next;
 
-#else
+    PackedDebugNode() = default;
+};
 
+template<typename T>
+struct PackedDebugTlsNode
+{
+    UINT64 BUFFER_GUARD_FRONT;
     T data;
+    UINT64 BUFFER_GUARD_END;
+    ULONG_PTR POOL_INSTANCE_VALUE;
     UINT64 next;
+    void* ownerPool;
 
-#endif // !_DEBUG
-
-    Node() = default;
+    PackedDebugTlsNode() = default;
 };
 
+#pragma pack(pop)
+
+// 정렬이 큰 타입용 디버그 노드. 앞을 채워서 앞쪽 가드가 정렬된 data 바로 앞 8바이트에 오도록 함
+// data의 크기는 정렬의 배수이므로 뒤쪽 가드는 data 바로 뒤에 붙음
 template<typename T>
-struct tlsNode
+struct AlignedDebugNode
 {
-    // x64 ȯ濡 ɰ ؼ UINT64  
-#ifdef _DEBUG
+    UINT8 padding[PoolNodeAlign<T> - sizeof(UINT64)];
+    UINT64 BUFFER_GUARD_FRONT;
+    alignas(PoolNodeAlign<T>) T data;
+    UINT64 BUFFER_GUARD_END;
+    ULONG_PTR POOL_INSTANCE_VALUE;
+    UINT64 next;
 
+    AlignedDebugNode() = default;
+};
+
+template<typename T>
+struct AlignedDebugTlsNode
+{
+    UINT8 padding[PoolNodeAlign<T> - sizeof(UINT64)];
     UINT64 BUFFER_GUARD_FRONT;
-    T data;
+    alignas(PoolNodeAlign<T>) T data;
     UINT64 BUFFER_GUARD_END;
     ULONG_PTR POOL_INSTANCE_VALUE;
     UINT64 next;
     void* ownerPool;
-    //Node<T>* next;
+
+    AlignedDebugTlsNode() = default;
+};
+
+template<typename T>
+using Node = std::conditional_t<(PoolNodeAlign<T> > sizeof(UINT64)), AlignedDebugNode<T>, PackedDebugNode<T>>;
+
+template<typename T>
+using tlsNode = std::conditional_t<(PoolNodeAlign<T> > sizeof(UINT64)), AlignedDebugTlsNode<T>, PackedDebugTlsNode<T>>;
 
 #else
 
-    T data;
+template<typename T>
+struct Node
+{
+    alignas(PoolNodeAlign<T>) T data;
+    UINT64 next;
+
+    Node() = default;
+};
+
+template<typename T>
+struct tlsNode
+{
+    alignas(PoolNodeAlign<T>) T data;
     UINT64 next;
     void* ownerPool;
 
-#endif // !_DEBUG
+    tlsNode() = default;
+};
+
+#endif // POOL_INTRUSIVE_NODE
+
+template<typename T>
+struct AddressConverter {
+    static constexpr UINT64 POINTER_MASK = 0x00007FFFFFFFFFFF; // 하위 47비트
+
+    // 노드 주소 추출
+    static Node<T>* ExtractNode(UINT64 taggedPointer) {
+        return reinterpret_cast<Node<T>*>(taggedPointer & POINTER_MASK);
+    }
+    static tlsNode<T>* ExtractTLSNode(UINT64 taggedPointer) {
+        return reinterpret_cast<tlsNode<T>*>(taggedPointer & POINTER_MASK);
+    }
+};
+
+// CAS 는 Platform.h 에서 std::atomic 기반으로 정의
+
+
+// free list top 의 ABA 방지 방식
+// 128비트 CAS 를 쓸 수 있다면 {포인터, 64비트 카운터} 를 한 번에 바꾸고 (MEMORYPOOL_WIDE_TAG)
+// 아니라면 (또는 MEMORYPOOL_PACKED_TAG 를 정의하면) 포인터 상위 17비트에 tag 를 넣음
+// 어느 쪽이든 새 tag 는 top 에 들어있던 tag + 1 이므로 전역 stamp 카운터를 증가시킬 필요가 없음
+#if POOL_HAS_CAS128 && !defined(MEMORYPOOL_PACKED_TAG)
+#define MEMORYPOOL_WIDE_TAG 1
+#else
+#define MEMORYPOOL_WIDE_TAG 0
+#endif
+
+// MEMORYPOOL_FREELIST_ELIMINATION 을 정의하면 free list 의 top CAS 에 실패했을 때 지수 백오프를 하고,
+// 노드 하나짜리 Push(Free)와 Pop(Alloc)은 제거 배열에서 만나 top 을 건드리지 않고 노드를 주고받음
+// 매거진을 끈 풀처럼 여러 스레드가 공유 free list 에 직접 몰리는 경우를 위한 옵션 (free list 마다 캐시 라인 ELIMINATION_SLOT_COUNT 개가 늘어남)
+
+// 노드끼리 next 로 연결되는 lock-free 스택 (Treiber stack)
+// NodeType 은 UINT64 next 필드를 가져야 하며, next 에는 tag 없는 다음 노드 주소를 저장함
+template<typename NodeType>
+class TaggedFreeList
+{
+public:
+    static constexpr UINT64 POINTER_MASK = 0x00007FFFFFFFFFFF; // 하위 47비트
+    static constexpr UINT64 STAMP_SHIFT = 47;
+
+    TaggedFreeList(void)
+    {
+        Clear();
+    }
+
+    // first ~ last 로 이미 연결된 체인을 한 번의 CAS 로 게시
+    void PushChain(NodeType* first, NodeType* last)
+    {
+#ifdef MEMORYPOOL_FREELIST_ELIMINATION
+        ExponentialBackoff backoff;
+#endif // MEMORYPOOL_FREELIST_ELIMINATION
+
+#if MEMORYPOOL_WIDE_TAG
+        UINT128 currentTop = Load128(&m_top);
+        UINT128 newTop;
+
+        while (true) {
+            last->next = currentTop.low; // 체인 마지막 노드의 next를 현재 top으로 설정
+
+            newTop.low = reinterpret_cast<UINT64>(first);
+            newTop.high = currentTop.high + 1;
+
+            if (CAS128(&m_top, currentTop, newTop)) {
+                break; // 성공적으로 Push 완료
+            }
+
+#ifdef MEMORYPOOL_FREELIST_ELIMINATION
+            if (first == last && m_elimination.TryPush(first)) {
+                break; // 동시에 Pop하던 스레드가 가져감
+            }
+            backoff.Pause();
+            currentTop = Load128(&m_top);
+#endif // MEMORYPOOL_FREELIST_ELIMINATION
+        }
+#else
+        UINT64 currentTop = m_top.load(std::memory_order_acquire);
+        UINT64 newTop;
+
+        while (true) {
+            last->next = currentTop & POINTER_MASK; // 체인 마지막 노드의 next를 현재 top으로 설정
+
+            newTop = MakeTop(first, NextStamp(currentTop));
+
+            if (m_top.compare_exchange_weak(currentTop, newTop, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                break; // 성공적으로 Push 완료
+            }
+
+#ifdef MEMORYPOOL_FREELIST_ELIMINATION
+            if (first == last && m_elimination.TryPush(first)) {
+                break; // 동시에 Pop하던 스레드가 가져감
+            }
+            backoff.Pause();
+            currentTop = m_top.load(std::memory_order_acquire);
+#endif // MEMORYPOOL_FREELIST_ELIMINATION
+        }
+#endif // MEMORYPOOL_WIDE_TAG
+    }
+
+    // top 부터 최대 maxCount 개의 노드를 한 번의 CAS 로 떼어내고 갯수를 반환
+    // 떼어낸 노드들은 first 부터 next 로 연결된 상태 (마지막 노드의 next 는 따라가면 안 됨). 비어 있다면 first 는 nullptr
+    UINT32 PopChain(NodeType*& first, UINT32 maxCount)
+    {
+        NodeType* currentNode;
+        UINT64 nextNode;
+        UINT32 count;
+
+#ifdef MEMORYPOOL_FREELIST_ELIMINATION
+        ExponentialBackoff backoff;
+#endif // MEMORYPOOL_FREELIST_ELIMINATION
+
+#if MEMORYPOOL_WIDE_TAG
+        UINT128 currentTop = Load128(&m_top);
+        UINT128 newTop;
+#else
+        UINT64 currentTop = m_top.load(std::memory_order_acquire);
+#endif // MEMORYPOOL_WIDE_TAG
+
+        while (true) {
+            currentNode = TopNode(currentTop);
+
+            if (!currentNode) {
+                first = nullptr;
+                return 0; // 스택이 비어 있음
+            }
+
+            first = currentNode;
+
+            // top부터 maxCount개를 따라감. top이 바뀌지 않았다면 이 체인도 그대로이므로 CAS 한 번으로 확정
+            count = 0;
+            bool bStale = false;
+            while (true) {
+                count++;
+                nextNode = currentNode->next;
+
+                if (count == maxCount) {
+                    break;
+                }
+
+                currentNode = reinterpret_cast<NodeType*>(nextNode);
+                if (!currentNode) {
+                    break;
+                }
+
+#if POOL_INTRUSIVE_NODE
+                // 침투형 배치에서는 다른 스레드가 이미 꺼내 간 노드의 next 자리에 사용자 데이터가 들어 있을 수 있음
+                // 방금 읽은 next가 진짜 연결인지 top이 그대로인 것으로 확인한 뒤에만 따라감
+                if (TopChanged(currentTop)) {
+                    bStale = true;
+                    break;
+                }
+#endif // POOL_INTRUSIVE_NODE
+            }
+
+            if (bStale) {
+#if MEMORYPOOL_WIDE_TAG
+                currentTop = Load128(&m_top);
+#else
+                currentTop = m_top.load(std::memory_order_acquire);
+#endif // MEMORYPOOL_WIDE_TAG
+                continue;
+            }
+
+#if MEMORYPOOL_WIDE_TAG
+            newTop.low = nextNode;
+            newTop.high = currentTop.high + 1;
+
+            if (CAS128(&m_top, currentTop, newTop)) {
+                return count;
+            }
+#else
+            if (m_top.compare_exchange_weak(currentTop, MakeTop(reinterpret_cast<NodeType*>(nextNode), NextStamp(currentTop)), std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return count;
+            }
+#endif // MEMORYPOOL_WIDE_TAG
+
+#ifdef MEMORYPOOL_FREELIST_ELIMINATION
+            // 노드 하나만 필요하다면 동시에 Free하던 스레드가 내놓은 노드를 받아 봄
+            if (maxCount == 1) {
+                NodeType* eliminated = m_elimination.TryPop();
+                if (eliminated) {
+                    first = eliminated;
+                    return 1;
+                }
+            }
+            backoff.Pause();
+#if MEMORYPOOL_WIDE_TAG
+            currentTop = Load128(&m_top);
+#else
+            currentTop = m_top.load(std::memory_order_acquire);
+#endif // MEMORYPOOL_WIDE_TAG
+#endif // MEMORYPOOL_FREELIST_ELIMINATION
+        }
+    }
+
+    // 노드 하나를 꺼냄. 비어 있다면 nullptr
+    NodeType* Pop(void)
+    {
+        NodeType* node;
+        return PopChain(node, 1) ? node : nullptr;
+    }
+
+    // 목록 전체를 한 번의 CAS로 떼어내고 top 노드를 반환. 비어 있다면 nullptr
+    // 노드를 따라가지 않고 top만 바꾸므로 동시에 Push가 계속 들어와도 목록 길이와 상관없이 끝남
+    // 떼어낸 노드는 next로 연결된 상태이며 마지막 노드의 next는 0
+    NodeType* PopAll(void)
+    {
+#if MEMORYPOOL_WIDE_TAG
+        UINT128 currentTop = Load128(&m_top);
+        UINT128 newTop;
+        while (TopNode(currentTop)) {
+            newTop.low = 0;
+            newTop.high = currentTop.high + 1;
+
+            if (CAS128(&m_top, currentTop, newTop)) {
+                return TopNode(currentTop);
+            }
+            currentTop = Load128(&m_top);
+        }
+#else
+        UINT64 currentTop = m_top.load(std::memory_order_acquire);
+        while (TopNode(currentTop)) {
+            if (m_top.compare_exchange_weak(currentTop, MakeTop(nullptr, NextStamp(currentTop)), std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return TopNode(currentTop);
+            }
+        }
+#endif // MEMORYPOOL_WIDE_TAG
+        return nullptr;
+    }
+
+    // 현재 top 노드. 다른 스레드가 접근하지 않는 소멸 시점에 목록을 훑을 때만 사용
+    NodeType* Head(void)
+    {
+#if MEMORYPOOL_WIDE_TAG
+        return TopNode(Load128(&m_top));
+#else
+        return TopNode(m_top.load(std::memory_order_acquire));
+#endif // MEMORYPOOL_WIDE_TAG
+    }
+
+    void Clear(void)
+    {
+#if MEMORYPOOL_WIDE_TAG
+        m_top.low = 0;
+        m_top.high = 0;
+#else
+        m_top.store(0, std::memory_order_relaxed);
+#endif // MEMORYPOOL_WIDE_TAG
+    }
+
+private:
+#if MEMORYPOOL_WIDE_TAG
+    static NodeType* TopNode(const UINT128& topValue) {
+        return reinterpret_cast<NodeType*>(topValue.low);
+    }
+
+    // topValue를 읽은 뒤 성공한 CAS가 있었는지. 앞서 읽은 next보다 뒤에 읽도록 acquire 펜스를 둠
+    bool TopChanged(const UINT128& topValue) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_top.high != topValue.high;
+    }
+#else
+    static NodeType* TopNode(UINT64 topValue) {
+        return reinterpret_cast<NodeType*>(topValue & POINTER_MASK);
+    }
+
+    // top 에 들어있던 stamp 의 다음 값
+    static UINT64 NextStamp(UINT64 topValue) {
+        return (topValue >> STAMP_SHIFT) + 1;
+    }
+
+    // 노드 주소에 stamp 추가
+    static UINT64 MakeTop(NodeType* node, UINT64 stamp) {
+        return (reinterpret_cast<UINT64>(node) & POINTER_MASK) | (stamp << STAMP_SHIFT);
+    }
+
+    // topValue를 읽은 뒤 top이 바뀌었는지. 앞서 읽은 next보다 뒤에 읽도록 acquire 펜스를 둠
+    bool TopChanged(UINT64 topValue) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_top.load(std::memory_order_relaxed) != topValue;
+    }
+#endif // MEMORYPOOL_WIDE_TAG
+
+private:
+#if MEMORYPOOL_WIDE_TAG
+    volatile UINT128 m_top; // 하위 64비트 : top 노드 주소, 상위 64비트 : 성공한 CAS 횟수
+#else
+    std::atomic<UINT64> m_top; // 하위 47비트 : top 노드 주소, 상위 17비트 : 성공한 CAS 횟수
+#endif // MEMORYPOOL_WIDE_TAG
+
+#ifdef MEMORYPOOL_FREELIST_ELIMINATION
+    EliminationArray<NodeType> m_elimination; // top CAS 실패 시 노드 하나를 직접 주고받는 자리
+#endif // MEMORYPOOL_FREELIST_ELIMINATION
+};
+
+
+// 슬랩 크기를 정할 때 기준이 되는 페이지 크기
+#define SLAB_PAGE_SIZE 4096
+
+// 페이지 크기로 나눴을 때 노드가 너무 적게 들어가는 큰 타입도 최소 이 정도는 한 번에 할당
+#define SLAB_MIN_NODE_COUNT 16
+
+// 슬랩 헤더. 슬랩은 [헤더][노드][노드]... 형태의 연속된 메모리 블록
+struct SlabHeader
+{
+    SlabHeader* next;   // 같은 풀이 할당한 다음 슬랩
+    UINT32 nodeCount;   // 이 슬랩에 들어 있는 노드 갯수
+    UINT32 homeShard;   // 슬랩 메모리를 잡은 NUMA 노드의 샤드. 반환된 노드는 이 샤드로 돌아감 (MemoryPool의 NUMA 모드에서만 사용)
+};
+
+// 노드 배열이 시작되는 오프셋. 헤더 뒤의 노드도 max_align_t 정렬을 유지하도록 올림
+constexpr size_t SLAB_HEADER_SIZE = (sizeof(SlabHeader) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+// NodeType 슬랩의 노드 배열 오프셋. 노드의 정렬이 max_align_t보다 크다면 그 정렬까지 올림
+// 슬랩 시작 주소도 이 정렬에 맞춰 받아오므로 (SlabAlign) 첫 노드부터 정렬됨
+template<typename NodeType>
+constexpr size_t SlabHeaderSize(void)
+{
+    return (alignof(NodeType) > SLAB_HEADER_SIZE) ? alignof(NodeType) : SLAB_HEADER_SIZE;
+}
+
+// 슬랩 시작 주소가 맞춰야 하는 정렬
+template<typename NodeType>
+constexpr size_t SlabAlign(void)
+{
+    return (alignof(NodeType) > alignof(std::max_align_t)) ? alignof(NodeType) : alignof(std::max_align_t);
+}
+
+// 슬랩 하나에 담을 기본 노드 갯수. 페이지 하나에 들어가는 만큼, 단 SLAB_MIN_NODE_COUNT 이상
+template<typename NodeType>
+constexpr UINT32 DefaultSlabNodeCount(void)
+{
+    constexpr size_t perPage = (SLAB_PAGE_SIZE > SlabHeaderSize<NodeType>()) ? (SLAB_PAGE_SIZE - SlabHeaderSize<NodeType>()) / sizeof(NodeType) : 0;
+    return perPage < SLAB_MIN_NODE_COUNT ? SLAB_MIN_NODE_COUNT : static_cast<UINT32>(perPage);
+}
+
+// 슬랩 안의 index번째 노드 주소
+template<typename NodeType>
+inline NodeType* SlabNode(SlabHeader* slab, UINT32 index)
+{
+    return reinterpret_cast<NodeType*>(reinterpret_cast<char*>(slab) + SlabHeaderSize<NodeType>() + sizeof(NodeType) * index);
+}
+
+// 노드 count개를 담는 슬랩의 전체 크기
+template<typename NodeType>
+constexpr size_t SlabBytes(UINT32 count)
+{
+    return SlabHeaderSize<NodeType>() + sizeof(NodeType) * count;
+}
+
+#if POOL_INTRUSIVE_NODE
+
+// 침투형 배치에서 tlsMemoryPool 슬랩을 나누는 세그먼트의 기본 크기
+// 노드가 커서 SLAB_MIN_NODE_COUNT개가 들어가지 않으면 들어갈 때까지 2배씩 키움
+#define SLAB_SEGMENT_SIZE (16 * 1024)
+
+// 세그먼트 헤더. 슬랩은 [헤더][노드]...[헤더][노드]... 형태로 세그먼트 크기 경계에 정렬되고, 노드는 세그먼트 경계에 걸치지 않음
+// 그래서 노드 주소의 하위 비트를 지우면 항상 그 노드가 속한 세그먼트 헤더가 나옴
+struct SlabSegmentHeader
+{
+    SlabHeader slab;    // 슬랩의 첫 세그먼트에서만 사용. SlabHeader*로 바로 바꿔 쓸 수 있도록 맨 앞에 둠
+    void* owner;        // 이 세그먼트의 노드를 만든 풀
+};
+
+constexpr size_t SLAB_SEGMENT_HEADER_SIZE = (sizeof(SlabSegmentHeader) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+// NodeType 세그먼트의 노드 배열 오프셋. 노드의 정렬이 더 크다면 그 정렬까지 올림
+template<typename NodeType>
+constexpr size_t SegmentHeaderSize(void)
+{
+    return (alignof(NodeType) > SLAB_SEGMENT_HEADER_SIZE) ? alignof(NodeType) : SLAB_SEGMENT_HEADER_SIZE;
+}
+
+// NodeType이 쓰는 세그먼트 크기 (2의 거듭제곱)
+template<typename NodeType>
+constexpr size_t SegmentSize(void)
+{
+    size_t size = SLAB_SEGMENT_SIZE;
+    while (size <= SegmentHeaderSize<NodeType>() || (size - SegmentHeaderSize<NodeType>()) / sizeof(NodeType) < SLAB_MIN_NODE_COUNT)
+        size <<= 1;
+    return size;
+}
+
+// 세그먼트 하나에 들어가는 노드 갯수
+template<typename NodeType>
+constexpr UINT32 SegmentNodeCount(void)
+{
+    return static_cast<UINT32>((SegmentSize<NodeType>() - SegmentHeaderSize<NodeType>()) / sizeof(NodeType));
+}
+
+// 세그먼트로 나뉜 슬랩 안의 index번째 노드 주소
+template<typename NodeType>
+inline NodeType* SegmentSlabNode(SlabHeader* slab, UINT32 index)
+{
+    constexpr UINT32 perSegment = SegmentNodeCount<NodeType>();
+    return reinterpret_cast<NodeType*>(reinterpret_cast<char*>(slab) + SegmentSize<NodeType>() * (index / perSegment)
+        + SegmentHeaderSize<NodeType>() + sizeof(NodeType) * (index % perSegment));
+}
+
+// 노드 count개를 담는 세그먼트 슬랩의 전체 크기
+template<typename NodeType>
+constexpr size_t SegmentSlabBytes(UINT32 count)
+{
+    return SegmentSize<NodeType>() * ((count + SegmentNodeCount<NodeType>() - 1) / SegmentNodeCount<NodeType>());
+}
+
+// 노드가 속한 세그먼트의 헤더
+template<typename NodeType>
+inline SlabSegmentHeader* SegmentOf(NodeType* node)
+{
+    return reinterpret_cast<SlabSegmentHeader*>(reinterpret_cast<uintptr_t>(node) & ~static_cast<uintptr_t>(SegmentSize<NodeType>() - 1));
+}
+
+#endif // POOL_INTRUSIVE_NODE
+
+// 자주 갱신되는 필드(free list top, 카운터)를 각자 다른 캐시 라인에 두는 배치
+// 풀 인스턴스가 많아서 크기가 더 중요하다면 MEMORYPOOL_COMPACT_LAYOUT 을 정의해서 끌 수 있음
+#ifdef MEMORYPOOL_COMPACT_LAYOUT
+#define POOL_CACHE_ALIGN
+#else
+#define POOL_CACHE_ALIGN alignas(CACHE_LINE_SIZE)
+#endif // MEMORYPOOL_COMPACT_LAYOUT
+
+// 스레드별 매거진 하나가 담을 수 있는 최대 노드 갯수
+#define MAGAZINE_SIZE 64
+
+// 매거진이 비거나 가득 찼을 때 공유 free list와 한 번에 주고받는 노드 갯수
+#define MAGAZINE_BATCH (MAGAZINE_SIZE / 2)
+
+// 스레드 하나가 같은 타입의 풀 몇 개까지 매거진을 동시에 유지할지
+#define MAGAZINE_SLOT_COUNT 4
+
+// 자동 trim 정책을 켰을 때, 공유 free list에 반환하는 경로 몇 번마다 한 번씩 watermark를 확인할지 (2의 거듭제곱)
+#define TRIM_CHECK_PERIOD 64
+
+// MEMORYPOOL_EPOCH_RECLAIM 을 정의하면 공유 free list에서 노드를 떼어내는 동안 EpochGuard로 보호 구간에 들어감
+// 그러면 Trim이 고른 슬랩을 물리 메모리만 반환하고 보관하지 않고, EpochReclaimer를 거쳐 주소 공간까지 OS에 반환할 수 있음
+// (보호 구간이 없으면 늦게 따라오는 Pop이 반환된 슬랩의 next를 읽을 수 있으므로 주소 공간을 유지해야 함)
+// 아레나에서 받은 슬랩은 개별로 반환할 수 없으므로 이 옵션과 상관없이 물리 메모리만 반환
+
+
+// MemoryPool 클래스 정의
+template<typename T, bool bPlacementNew>
+class MemoryPool
+{
+    // 침투형 배치에서는 free list에 있는 노드의 앞 8바이트가 next로 덮임
+    // bPlacementNew = false 는 반환된 객체의 상태를 다음 Alloc에 그대로 넘겨주는 방식이므로 T의 종류와 상관없이 깨짐
+    // 메모리만 필요하다면 PoolRawStorage<T> 를 bPlacementNew = true 로 씀
+    static_assert(!POOL_INTRUSIVE_NODE || bPlacementNew,
+        "MEMORYPOOL_INTRUSIVE_LAYOUT requires bPlacementNew for MemoryPool (use PoolRawStorage<T> for raw storage)");
+
+public:
+    // 생성자
+    // slabNodeCount : 풀이 비었을 때 한 번에 할당할 노드 갯수, 0이면 페이지 크기에 맞춰 결정
+    // bUseMagazine : 스레드별 매거진 캐시 사용 여부. 켜져 있으면 Alloc/Free 대부분이 원자 연산 없이 처리됨
+    // arena : 슬랩을 잘라 올 아레나. nullptr이면 슬랩마다 OS 페이지를 따로 받음. 아레나는 풀보다 오래 살아야 함
+    // bNumaAware : NUMA 노드마다 free list를 따로 두고, 슬랩은 만든 스레드의 노드 메모리에 잡음
+    //              Alloc은 현재 노드의 free list를 먼저 쓰고, 비어 있을 때만 다른 노드에서 가져옴
+    //              반환된 노드는 반환한 스레드가 아니라 슬랩을 만든 노드의 free list로 돌아감
+    MemoryPool(UINT32 sizeInitialize = 0, UINT32 slabNodeCount = 0, bool bUseMagazine = true, SlabArena* arena = nullptr, bool bNumaAware = false);
+
+    // 소멸자
+    virtual ~MemoryPool(void);
+
+    // 풀에 있는 객체를 넘겨주거나 새로 할당해 넘김
+    T* Alloc(void);
+
+    // 객체를 풀에 반환
+    bool Free(T* ptr);
+
+    // 객체 n개를 한 번에 할당해 out에 채움. 공유 free list에서 체인을 한 번의 CAS로 떼어냄 (매거진은 거치지 않음)
+    void AllocBulk(T** out, size_t n);
+
+    // 객체 n개를 한 번에 반환. 로컬에서 미리 연결한 뒤 한 번의 CAS로 free list에 게시
+    bool FreeBulk(T** in, size_t n);
+
+public:
+    // 공유 free list에 있는 노드 갯수. 스레드별 매거진에 캐시된 노드는 포함되지 않음
+    // 카운터는 샤드로 나뉘어 있어서 읽을 때만 합산함. 측정 중인 값이므로 근사값
+    UINT32 GetCurPoolCount(void) { LONG64 count = m_curPoolCount.Load(); return count > 0 ? static_cast<UINT32>(count) : 0; }
+    UINT32 GetMaxPoolCount(void) { LONG64 count = m_maxPoolCount.Load(); return count > 0 ? static_cast<UINT32>(count) : 0; }
+    UINT32 GetSlabNodeCount(void) { return m_slabNodeCount; }
+
+    // Trim으로 지금까지 OS에 돌려준 바이트 수 (누적)
+    UINT64 GetReclaimedBytes(void) { return m_reclaimedBytes.load(std::memory_order_relaxed); }
+
+    // NUMA 샤드 통계. NUMA 모드가 아니라면 샤드는 하나
+    // hit : 현재 노드의 샤드에서 꺼낸 노드 수, steal : 현재 샤드가 비어서 다른 샤드에서 가져간 노드 수
+    UINT32 GetNumaShardCount(void) { return m_shardCount; }
+    UINT64 GetShardHitCount(UINT32 shard) { return m_shards[shard].hitCount.load(std::memory_order_relaxed); }
+    UINT64 GetShardStealCount(UINT32 shard) { return m_shards[shard].stealCount.load(std::memory_order_relaxed); }
+
+public:
+    // 공유 free list에 keep개 정도만 남기고, 노드가 전부 비어 있는 슬랩의 물리 메모리를 OS에 반환. 반환한 바이트 수를 리턴
+    // 슬랩 단위로만 반환하므로 keep보다 조금 더 남을 수 있음. 스레드 매거진에 들어 있는 노드는 대상이 아님
+    // 반환한 슬랩은 주소 공간을 유지한 채 보관했다가 다음에 슬랩이 필요할 때 다시 사용
+    size_t Trim(size_t keep);
+
+    // 자동 trim 정책. 공유 free list의 노드 수가 intervalMs 동안 계속 highWatermark를 넘으면 highWatermark만 남기고 Trim
+    // 별도 스레드 없이 Free 경로에서 가끔 확인함. highWatermark가 0이면 끔 (기본값)
+    void SetTrimPolicy(UINT32 highWatermark, UINT32 intervalMs);
+
+private:
+    // 스레드별로 풀 하나에 대해 캐시하는 노드 묶음
+    struct Magazine
+    {
+        UINT64 poolId;                      // 이 매거진의 주인 풀 id, 0이면 빈 슬롯
+        UINT32 count;                       // 현재 담긴 노드 갯수
+        Node<T>* nodes[MAGAZINE_SIZE];
+    };
+
+    // 스레드 하나가 가지는 매거진 슬롯 모음. 스레드가 끝나면 남은 노드를 주인 풀로 돌려줌
+    struct MagazineCache
+    {
+        Magazine slots[MAGAZINE_SLOT_COUNT] = {};
+
+        ~MagazineCache()
+        {
+            for (Magazine& mag : slots)
+            {
+                ReleaseMagazine(mag);
+            }
+        }
+    };
+
+    // 살아있는 풀 목록. 스레드 종료나 슬롯 교체처럼 드문 경로에서만 사용
+    struct PoolRegistry
+    {
+        std::mutex lock;
+        std::unordered_map<UINT64, MemoryPool*> pools;
+    };
+
+    // 정적 객체 소멸 순서에 휘말리지 않도록 일부러 해제하지 않음
+    static PoolRegistry& GetRegistry(void)
+    {
+        static PoolRegistry* registry = new PoolRegistry;
+        return *registry;
+    }
+
+    // 현재 스레드에서 이 풀이 사용할 매거진을 찾거나 새로 배정
+    Magazine* GetMagazine(void);
+
+    // 다른 풀의 매거진이 차지하던 슬롯을 비움. 주인 풀이 살아있다면 노드를 돌려주고, 아니라면 버림
+    static void ReleaseMagazine(Magazine& mag);
+
+    // 매거진이 비었을 때 공유 free list(또는 새 슬랩)에서 MAGAZINE_BATCH개를 가져옴
+    void RefillMagazine(Magazine* mag);
+
+    // 매거진이 가득 찼을 때 오래된 노드 count개를 연결해서 공유 free list에 한 번에 돌려줌
+    void FlushMagazine(Magazine* mag, UINT32 count);
+
+    // count개의 노드를 담은 슬랩을 할당해 슬랩 목록에 등록
+    // new로 노드를 만들던 때와 같이 메모리를 받아오지 못하면 std::bad_alloc
+    SlabHeader* AllocSlab(UINT32 count);
+
+    // 슬랩 메모리를 받아온 곳(아레나 또는 OS)에 반환
+    void FreeSlab(SlabHeader* slab, UINT32 nodeCount);
+
+    // first ~ last로 이미 연결된 노드 count개를 한 번의 CAS로 free list에 게시
+    // 노드들은 모두 주인 샤드가 같아야 함. 섞여 있을 수 있다면 PushNodes를 사용
+    void PushChain(Node<T>* first, Node<T>* last, UINT32 count);
+
+    // nodes[0] ~ nodes[count - 1]을 주인 샤드가 같은 구간끼리 연결해서 게시
+    void PushNodes(Node<T>** nodes, UINT32 count);
+
+    // free list의 top부터 최대 maxCount개의 노드를 한 번의 CAS로 떼어내고 갯수를 반환
+    // 떼어낸 노드들은 first부터 next로 연결된 상태
+    // Trim이 free list를 떼어간 사이에 비어 보였다면 슬랩을 새로 만들지 않도록 다시 게시될 때까지 기다림
+    UINT32 PopChain(Node<T>*& first, UINT32 maxCount);
+
+    // 샤드들을 돌며 한 번씩 떼어냄. 보호 구간은 호출하는 쪽에서 잡음
+    UINT32 PopChainFromShards(Node<T>*& first, UINT32 maxCount);
+
+    // 노드 count개를 연결된 체인으로 확보. free list가 비었다면 슬랩을 새로 할당하고 남는 노드는 free list에 게시
+    UINT32 TakeChain(Node<T>*& first, UINT32 count);
+
+    // m_trimLock을 잡은 상태에서 호출하는 Trim 본체
+    size_t TrimLocked(size_t keep);
+
+    // 자동 trim 정책이 켜져 있다면 watermark를 넘은 시간을 확인하고 필요하면 Trim
+    void MaybeTrim(void);
+
+    // Trim으로 물리 메모리를 반환하고 보관 중인 슬랩
+    struct DiscardedSlab
+    {
+        SlabHeader* slab;
+        UINT32 nodeCount;
+    };
+
+    // NUMA 노드 하나의 free list. NUMA 모드가 아니라면 하나만 사용
+    struct NumaShard
+    {
+        POOL_CACHE_ALIGN TaggedFreeList<Node<T>> freeList; // 반환된 노드 스택, Node<T>* m_freeNode가 바뀐 형태
+
+        // 이 샤드를 현재 노드로 쓰는 스레드가 갱신. 노드를 체인 단위로 꺼낼 때만 더하므로 자주 바뀌지 않음
+        POOL_CACHE_ALIGN std::atomic<UINT64> hitCount{ 0 };
+        std::atomic<UINT64> stealCount{ 0 };
+    };
+
+    // 현재 스레드가 쓸 샤드
+    UINT32 CurrentShard(void) { return (m_shardCount == 1) ? 0 : NumaTopology::GetCurrentNode() % m_shardCount; }
+
+    // 노드가 속한 슬랩을 만든 샤드. NUMA 모드에서는 슬랩을 m_slabSpan 경계에 두므로 주소를 마스킹해서 슬랩 헤더를 찾음 (SegmentOf와 같은 방식)
+    UINT32 HomeShard(Node<T>* node)
+    {
+        if (m_shardCount == 1)
+            return 0;
+        return reinterpret_cast<SlabHeader*>(reinterpret_cast<uintptr_t>(node) & ~static_cast<uintptr_t>(m_slabSpan - 1))->homeShard;
+    }
+
+private:
+    //Node<T>* m_freeNode;
+    NumaShard* m_shards;    // 노드별 free list 배열
+    UINT32 m_shardCount;    // NUMA 모드라면 노드 수, 아니라면 1
+
+    // 통계용 카운터. 스레드별 샤드에 나눠 더하므로 Alloc/Free마다 같은 캐시 라인을 두고 경쟁하지 않음
+    ShardedCounter m_curPoolCount; // 풀에서 사용하는 노드 갯수, Alloc되면 1 감소, Free되면 1 증가
+    ShardedCounter m_maxPoolCount; // 풀에서 사용하는 최대 노드 갯수
+
+    // 이하 자주 바뀌지 않는 필드
+    POOL_CACHE_ALIGN std::atomic<SlabHeader*> m_slabList; // 할당한 슬랩 목록. 소멸자에서 슬랩 단위로 해제
+    UINT32 m_slabNodeCount; // 풀이 비었을 때 한 번에 할당할 노드 갯수
+    SlabArena* m_arena;     // 슬랩을 잘라 올 아레나, nullptr이면 OS 페이지
+
+    // NUMA 모드에서 슬랩이 정렬되는 경계 (2의 거듭제곱). 슬랩은 이 크기를 넘지 않으므로 노드 주소를 마스킹하면 슬랩 헤더가 나옴
+    // NUMA 모드가 아니라면 0이고 슬랩 크기 제한도 없음
+    size_t m_slabSpan;
+    UINT32 m_slabMaxNodeCount; // 슬랩 하나에 담을 수 있는 최대 노드 갯수
+
+    UINT64 m_poolId; // 매거진 슬롯을 찾기 위한 풀 고유 id, 매거진을 쓰지 않는다면 0
+    static inline thread_local MagazineCache t_magazineCache; // 스레드별 매거진
+
+    // trim 관련. Trim 끼리, 그리고 보관 중인 슬랩 목록을 m_trimLock으로 보호
+    std::mutex m_trimLock;
+    std::vector<DiscardedSlab> m_discardedSlabs;
+    std::atomic<UINT32> m_discardedSlabCount{ 0 };   // 락 없이 보관 슬랩이 있는지 확인하는 용도
+    std::atomic<bool> m_bTrimDetached{ false };      // Trim이 free list를 떼어가서 다시 게시하기 전까지 true
+    std::atomic<UINT64> m_reclaimedBytes{ 0 };
+    std::atomic<UINT32> m_trimWatermark{ 0 };        // 0이면 자동 trim 꺼짐
+    UINT32 m_trimIntervalMs = 0;
+    std::atomic<LONG64> m_aboveWatermarkSinceMs{ 0 }; // watermark를 넘기 시작한 시각, 0이면 넘지 않은 상태
+    static inline thread_local UINT32 t_trimTick = 0;
+};
+
+template<typename T, bool bPlacementNew>
+inline MemoryPool<T, bPlacementNew>::MemoryPool(UINT32 sizeInitialize, UINT32 slabNodeCount, bool bUseMagazine, SlabArena* arena, bool bNumaAware)
+{
+
+    m_slabList = nullptr;
+    m_arena = arena;
+
+    m_shardCount = bNumaAware ? NumaTopology::GetNodeCount() : 1;
+    m_shards = new NumaShard[m_shardCount];
+    m_slabNodeCount = (slabNodeCount == 0) ? DefaultSlabNodeCount<Node<T>>() : slabNodeCount;
+
+    m_slabSpan = 0;
+    m_slabMaxNodeCount = UINT32_MAX;
+    if (m_shardCount > 1)
+    {
+        // 기본 슬랩이 들어가는 가장 작은 2의 거듭제곱. 기본 슬랩 크기는 페이지에 맞춰져 있으므로 보통 페이지 하나
+        m_slabSpan = PoolPageSize();
+        while (m_slabSpan < SlabBytes<Node<T>>(m_slabNodeCount) || m_slabSpan < SlabAlign<Node<T>>())
+            m_slabSpan <<= 1;
+
+        size_t maxCount = (m_slabSpan - SlabHeaderSize<Node<T>>()) / sizeof(Node<T>);
+        m_slabMaxNodeCount = (maxCount > UINT32_MAX) ? UINT32_MAX : static_cast<UINT32>(maxCount);
+    }
+
+    m_poolId = 0;
+    if (bUseMagazine)
+    {
+        // id는 풀이 사라진 뒤에도 재사용하지 않음. 남아있는 매거진이 엉뚱한 풀에 붙지 않도록
+        static std::atomic<UINT64> s_poolIdCounter{ 0 };
+        m_poolId = s_poolIdCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+
+        PoolRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lk(registry.lock);
+        registry.pools[m_poolId] = this;
+    }
+
+    // 초기 메모리 공간 준비. 요청한 갯수만큼 슬랩 하나로 잡아서 통째로 free list에 넣음
+    // NUMA 모드라면 슬랩 크기 제한이 있으므로 여러 슬랩으로 나눔
+    while (sizeInitialize > 0)
+    {
+        UINT32 count = (sizeInitialize > m_slabMaxNodeCount) ? m_slabMaxNodeCount : sizeInitialize;
+        SlabHeader* slab = AllocSlab(count);
+        PushChain(SlabNode<Node<T>>(slab, 0), SlabNode<Node<T>>(slab, count - 1), count);
+        sizeInitialize -= count;
+    }
+}
+
+template<typename T, bool bPlacementNew>
+inline MemoryPool<T, bPlacementNew>::~MemoryPool(void)
+{
+    if (m_poolId != 0)
+    {
+        // 목록에서 빠진 뒤로는 다른 스레드의 매거진이 이 풀에 노드를 돌려주지 않음
+        PoolRegistry& registry = GetRegistry();
+        {
+            std::lock_guard<std::mutex> lk(registry.lock);
+            registry.pools.erase(m_poolId);
+        }
+
+        // 현재 스레드의 매거진은 바로 비움. 다른 스레드의 매거진은 슬롯이 교체될 때 버려짐
+        for (Magazine& mag : t_magazineCache.slots)
+        {
+            if (mag.poolId == m_poolId)
+            {
+                mag.poolId = 0;
+                mag.count = 0;
+            }
+        }
+    }
+
+    // 만약 할당 해제가 전부 완료되지 않았다면
+    if (GetCurPoolCount() != GetMaxPoolCount())
+    {
+        // 음... 어떻게할지 나중에 정하자구.
+    }
+
+    // 노드를 하나씩 지우지 않고 슬랩 단위로 해제
+    SlabHeader* slab = m_slabList.load(std::memory_order_acquire);
+    while (slab)
+    {
+        SlabHeader* nextSlab = slab->next;
+        FreeSlab(slab, slab->nodeCount);
+        slab = nextSlab;
+    }
+
+    // Trim으로 물리 메모리만 반환해 둔 슬랩은 주소 공간까지 반환
+    for (DiscardedSlab& discarded : m_discardedSlabs)
+    {
+        FreeSlab(discarded.slab, discarded.nodeCount);
+    }
+    m_discardedSlabs.clear();
+
+    m_slabList.store(nullptr, std::memory_order_relaxed);
+    delete[] m_shards;
+    m_shards = nullptr;
+    m_curPoolCount.Reset();
+    m_maxPoolCount.Reset();
+}
+
+template<typename T, bool bPlacementNew>
+inline SlabHeader* MemoryPool<T, bPlacementNew>::AllocSlab(UINT32 count)
+{
+    SlabHeader* slab = nullptr;
+
+    // Trim으로 반환해 둔 같은 크기의 슬랩이 있다면 주소 공간을 재사용
+    if (m_discardedSlabCount.load(std::memory_order_relaxed) > 0)
+    {
+        std::lock_guard<std::mutex> lk(m_trimLock);
+        for (size_t i = 0; i < m_discardedSlabs.size(); i++)
+        {
+            if (m_discardedSlabs[i].nodeCount == count)
+            {
+                slab = m_discardedSlabs[i].slab;
+                m_discardedSlabs[i] = m_discardedSlabs.back();
+                m_discardedSlabs.pop_back();
+                m_discardedSlabCount.fetch_sub(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+
+    bool bReused = (slab != nullptr);
+    if (!bReused)
+    {
+        // 헤더 + 노드 count개를 하나의 연속된 블록으로 할당. Trim에서 페이지 단위로 OS에 돌려줄 수 있도록 페이지 경계로 받음 (0으로 채워져 있음)
+        // 노드 정렬이 페이지보다 큰 타입은 그 정렬에 맞춤. NUMA 모드라면 HomeShard가 마스킹할 수 있도록 m_slabSpan 경계에 맞춤
+        size_t align = (m_shardCount > 1) ? m_slabSpan : SlabAlign<Node<T>>();
+        if (m_arena)
+            slab = (SlabHeader*)m_arena->Allocate(SlabBytes<Node<T>>(count), align);
+        else
+            slab = (SlabHeader*)PoolPageAllocAligned(SlabBytes<Node<T>>(count), align);
+
+        if (slab == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+    // NUMA 모드라면 처음 접근하기 전에 현재 노드의 메모리로 잡히도록 요청. 슬랩 노드는 이 노드의 샤드에 게시됨
+    // 그 사이 스레드가 다른 노드로 옮겨 가도 헤더에는 메모리를 잡은 노드가 남도록 한 번만 읽음
+    UINT32 homeShard = CurrentShard();
+    if (m_shardCount > 1)
+    {
+        NumaTopology::BindToNode(slab, SlabBytes<Node<T>>(count), homeShard);
+    }
+
+    if (bReused)
+    {
+        // 플랫폼에 따라 이전 값이 남아 있을 수 있으므로 새 슬랩과 같게 0으로 채움
+        memset(slab, 0, SlabBytes<Node<T>>(count));
+    }
+
+    slab->nodeCount = count;
+    slab->homeShard = homeShard;
+
+    // 슬랩 안의 노드들을 미리 서로 연결. 마지막 노드의 next는 게시할 때 채움
+    for (UINT32 i = 0; i < count; i++)
+    {
+        Node<T>* newNode = SlabNode<Node<T>>(slab, i);
+
+#ifdef _DEBUG
+        // 디버깅용 가드. 가드 값도 확인하고, 반환되는 풀의 정보가 올바른지 확인하기 위해 사용
+        newNode->BUFFER_GUARD_FRONT = GUARD_VALUE;
+        newNode->BUFFER_GUARD_END = GUARD_VALUE;
+
+        newNode->POOL_INSTANCE_VALUE = reinterpret_cast<ULONG_PTR>(this);
+#endif // _DEBUG
+
+        newNode->next = (i + 1 < count) ? reinterpret_cast<UINT64>(SlabNode<Node<T>>(slab, i + 1)) : 0;
+    }
+
+    // 슬랩 목록에 등록. 여러 스레드가 동시에 슬랩을 만들 수 있으므로 CAS로 연결
+    SlabHeader* currentHead;
+    currentHead = m_slabList.load(std::memory_order_relaxed);
+    do {
+        slab->next = currentHead;
+    } while (!m_slabList.compare_exchange_weak(currentHead, slab, std::memory_order_release, std::memory_order_relaxed));
+
+    // 풀에서 사용하는 최대 노드 갯수를 슬랩 크기만큼 증가
+    m_maxPoolCount.Add(count);
+
+    POOL_TRACE(SlabAlloc, this, slab, count);
+
+    return slab;
+}
+
+template<typename T, bool bPlacementNew>
+inline void MemoryPool<T, bPlacementNew>::FreeSlab(SlabHeader* slab, UINT32 nodeCount)
+{
+    if (m_arena)
+        m_arena->Release(slab, SlabBytes<Node<T>>(nodeCount));
+    else
+        PoolPageFree(slab, SlabBytes<Node<T>>(nodeCount));
+}
+
+template<typename T, bool bPlacementNew>
+inline void MemoryPool<T, bPlacementNew>::PushChain(Node<T>* first, Node<T>* last, UINT32 count)
+{
+    POOL_TRACE(PushChain, this, first, count);
+
+    // 반환하는 스레드가 아니라 슬랩을 만든 노드의 샤드에 게시. 그래야 그 샤드에서 꺼낸 노드가 실제로 그 노드의 메모리임
+    m_shards[HomeShard(first)].freeList.PushChain(first, last);
+
+    // 풀에 존재하는 노드 갯수를 count만큼 증가
+    m_curPoolCount.Add(count);
+}
+
+template<typename T, bool bPlacementNew>
+inline void MemoryPool<T, bPlacementNew>::PushNodes(Node<T>** nodes, UINT32 count)
+{
+    // 주인 샤드가 바뀔 때마다 지금까지 연결한 구간을 게시. 샤드가 하나라면 통째로 한 번에 게시됨
+    UINT32 begin = 0;
+    UINT32 shard = HomeShard(nodes[0]);
+    for (UINT32 i = 1; i <= count; i++)
+    {
+        UINT32 nextShard = (i < count) ? HomeShard(nodes[i]) : shard;
+        if (i < count && nextShard == shard)
+        {
+            nodes[i - 1]->next = reinterpret_cast<UINT64>(nodes[i]);
+            continue;
+        }
+
+        PushChain(nodes[begin], nodes[i - 1], i - begin);
+        begin = i;
+        shard = nextShard;
+    }
+}
+
+template<typename T, bool bPlacementNew>
+inline UINT32 MemoryPool<T, bPlacementNew>::PopChain(Node<T>*& first, UINT32 maxCount)
+{
+#ifdef MEMORYPOOL_EPOCH_RECLAIM
+    // top 노드의 next를 읽는 동안 Trim이 그 슬랩을 unmap하지 못하도록 보호 구간에 들어감
+    EpochGuard guard;
+#endif // MEMORYPOOL_EPOCH_RECLAIM
+
+    UINT32 count = PopChainFromShards(first, maxCount);
+
+    // Trim이 free list를 떼어간 상태라서 비어 보였다면, 슬랩을 새로 만들지 않고 Trim이 남길 노드를 다시 게시할 때까지 기다림
+    // flag는 떼어내기 전에 켜고 다시 게시한 뒤에 끄므로, 떼어낸 top을 본 Pop은 반드시 켜진 flag를 봄
+    while (count == 0 && m_bTrimDetached.load(std::memory_order_seq_cst))
+    {
+        std::this_thread::yield();
+        count = PopChainFromShards(first, maxCount);
+    }
+    if (count == 0)
+    {
+        count = PopChainFromShards(first, maxCount);
+    }
+
+    // 풀에 존재하는 노드 갯수를 count만큼 감소
+    if (count > 0)
+    {
+        m_curPoolCount.Sub(count);
+        POOL_TRACE(PopChain, this, first, count);
+    }
+
+    return count;
+}
+
+template<typename T, bool bPlacementNew>
+inline UINT32 MemoryPool<T, bPlacementNew>::PopChainFromShards(Node<T>*& first, UINT32 maxCount)
+{
+    UINT32 local = CurrentShard();
+    UINT32 count = m_shards[local].freeList.PopChain(first, maxCount);
+
+    if (m_shardCount > 1)
+    {
+        if (count > 0)
+        {
+            m_shards[local].hitCount.fetch_add(count, std::memory_order_relaxed);
+        }
+        else
+        {
+            // 현재 노드의 샤드가 비었을 때만 가까운 번호부터 다른 샤드에서 가져옴
+            for (UINT32 i = 1; i < m_shardCount && count == 0; i++)
+            {
+                count = m_shards[(local + i) % m_shardCount].freeList.PopChain(first, maxCount);
+            }
+
+            if (count > 0)
+                m_shards[local].stealCount.fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+
+    return count;
+}
+
+template<typename T, bool bPlacementNew>
+inline typename MemoryPool<T, bPlacementNew>::Magazine* MemoryPool<T, bPlacementNew>::GetMagazine(void)
+{
+    Magazine* slots = t_magazineCache.slots;
+
+    for (UINT32 i = 0; i < MAGAZINE_SLOT_COUNT; i++)
+    {
+        if (slots[i].poolId == m_poolId)
+            return &slots[i];
+    }
+
+    // 처음 쓰는 풀이라면 빈 슬롯을 배정하고, 빈 슬롯이 없다면 첫 슬롯을 비워서 사용
+    Magazine* mag = &slots[0];
+    for (UINT32 i = 0; i < MAGAZINE_SLOT_COUNT; i++)
+    {
+        if (slots[i].poolId == 0)
+        {
+            mag = &slots[i];
+            break;
+        }
+    }
+
+    ReleaseMagazine(*mag);
+    mag->poolId = m_poolId;
+
+    return mag;
+}
+
+template<typename T, bool bPlacementNew>
+inline void MemoryPool<T, bPlacementNew>::ReleaseMagazine(Magazine& mag)
+{
+    if (mag.poolId != 0 && mag.count > 0)
+    {
+        // 풀이 소멸 중이라면 소멸자가 registry 락을 잡을 때까지 기다리므로 여기서 돌려주는 동안은 안전
+        PoolRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lk(registry.lock);
+
+        auto it = registry.pools.find(mag.poolId);
+        if (it != registry.pools.end())
+        {
+            it->second->FlushMagazine(&mag, mag.count);
+        }
+    }
+
+    mag.poolId = 0;
+    mag.count = 0;
+}
+
+template<typename T, bool bPlacementNew>
+inline UINT32 MemoryPool<T, bPlacementNew>::TakeChain(Node<T>*& first, UINT32 count)
+{
+    UINT32 popped = PopChain(first, count);
+    if (popped > 0)
+        return popped;
+
+    // 공유 free list도 비어 있다면 요청한 갯수 이상을 담는 슬랩을 새로 할당
+    // NUMA 모드에서 슬랩 하나에 담을 수 없을 만큼 요청했다면 담을 수 있는 만큼만 넘김 (AllocBulk가 나머지를 다시 요청)
+    UINT32 slabCount = (count > m_slabNodeCount) ? count : m_slabNodeCount;
+    if (slabCount > m_slabMaxNodeCount)
+    {
+        slabCount = m_slabMaxNodeCount;
+        if (count > slabCount)
+            count = slabCount;
+    }
+    SlabHeader* slab = AllocSlab(slabCount);
+
+    // 앞쪽 count개는 가져가고, 남는 노드는 한 번의 CAS로 free list에 게시
+    if (slabCount > count)
+    {
+        PushChain(SlabNode<Node<T>>(slab, count), SlabNode<Node<T>>(slab, slabCount - 1), slabCount - count);
+    }
+
+    first = SlabNode<Node<T>>(slab, 0);
+    return count;
+}
+
+template<typename T, bool bPlacementNew>
+inline void MemoryPool<T, bPlacementNew>::RefillMagazine(Magazine* mag)
+{
+    Node<T>* pNode = nullptr;
+    UINT32 count = TakeChain(pNode, MAGAZINE_BATCH);
+
+    for (UINT32 i = 0; i < count; i++)
+    {
+        mag->nodes[i] = pNode;
+
+        // 마지막 노드의 next는 이미 다른 노드를 가리킬 수 있으므로 따라가지 않음
+        if (i + 1 < count)
+            pNode = AddressConverter<T>::ExtractNode(pNode->next);
+    }
+
+    mag->count = count;
+}
+
+template<typename T, bool bPlacementNew>
+inline void MemoryPool<T, bPlacementNew>::FlushMagazine(Magazine* mag, UINT32 count)
+{
+    // 가장 오래 전에 들어온 노드부터 count개를 연결. 최근에 반환된 노드는 캐시에 남겨둠
+    // 다른 노드에서 만든 객체가 섞여 있을 수 있으므로 주인 샤드별로 나눠서 게시
+    PushNodes(mag->nodes, count);
+
+    mag->count -= count;
+    memmove(mag->nodes, mag->nodes + count, sizeof(Node<T>*) * mag->count);
+
+    MaybeTrim();
+}
+
+// 만약 비어있다면 할당, 있다면 pop하고 반환인데...
+template<typename T, bool bPlacementNew>
+inline T* MemoryPool<T, bPlacementNew>::Alloc(void)
+{
+    // 매거진을 쓰는 풀이라면 스레드 캐시에서 원자 연산 없이 꺼냄
+    if (m_poolId != 0)
+    {
+        Magazine* mag = GetMagazine();
+        if (mag->count == 0)
+        {
+            RefillMagazine(mag);
+        }
+
+        Node<T>* pNode = mag->nodes[--mag->count];
+
+        if constexpr (bPlacementNew)
+        {
+            new (&(pNode->data)) T();
+        }
+
+        POOL_TRACE(Alloc, this, &pNode->data, POOL_TRACE_SOURCE_MAGAZINE);
+        return &pNode->data;
+    }
+
+    // free list에서 하나를 꺼냄. tag는 top에 들어있던 값을 이어서 증가시키므로 전역 stamp를 건드리지 않음
+    Node<T>* currentNode = nullptr;
+    if (PopChain(currentNode, 1) == 0)
+        currentNode = nullptr;
+
+    // 스택이 비어 있다면 새로 슬랩을 할당해서 반환
+    if (!currentNode) {
+        // m_freeNode가 nullptr이라면 풀에 객체가 존재하지 않는다는 의미이므로 슬랩 단위로 새로 할당
+
+        // 노드 하나씩 malloc하지 않고 m_slabNodeCount개를 한 번에 할당
+        SlabHeader* slab = AllocSlab(m_slabNodeCount);
+        Node<T>* newNode = SlabNode<Node<T>>(slab, 0);
+
+        // 첫 노드는 바로 반환하고, 나머지는 한 번의 CAS로 free list에 게시
+        if (m_slabNodeCount > 1)
+        {
+            PushChain(SlabNode<Node<T>>(slab, 1), SlabNode<Node<T>>(slab, m_slabNodeCount - 1), m_slabNodeCount - 1);
+        }
+
+        newNode->next = 0;
+
+        // 처음에는 생성자를 호출 -> tlsMemoryPool이랑 다른 부분인데 나중에 수정이 필요함. 당장은 원인을 모르겠다.
+        if constexpr (bPlacementNew)
+        {
+            //new (reinterpret_cast<char*>(newNode) + offsetof(Node<T>, data)) T();
+            new (&(newNode->data)) T();
+        }
+
+        POOL_TRACE(Alloc, this, &newNode->data, POOL_TRACE_SOURCE_NEW_SLAB);
+
+        // 객체의 T타입 데이터 반환
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(newNode) + offsetof(Node<T>, data));
+    }
+
+    // 재사용시 placement New 옵션이 켜져있다면 생성자 호출
+    if constexpr (bPlacementNew)
+    {
+        //new (reinterpret_cast<char*>(returnNode) + offsetof(Node<T>, data)) T();
+        new (&(currentNode->data)) T();
+    }
+
+    // 풀에 존재하는 노드 갯수는 PopChain에서 감소
+
+    POOL_TRACE(Alloc, this, &currentNode->data, POOL_TRACE_SOURCE_SHARED);
+
+    // 객체의 T타입 데이터 반환
+    return &currentNode->data;
+}
+
+template<typename T, bool bPlacementNew>
+inline bool MemoryPool<T, bPlacementNew>::Free(T* ptr)
+{
+#ifdef _DEBUG
+    // 반환하는 값이 존재하지 않는다면
+    if (ptr == nullptr)
+    {
+        POOL_TRACE(FreeRejected, this, ptr, POOL_TRACE_REJECT_NULL);
+
+        // 실패
+        return false;
+    }
+#endif // _DEBUG
+
+    // offsetof(Node<T>, data)) => Node 구조체의 data 변수와 Node 구조체와의 주소 차이값을 계산
+    // 여기선 debug 모드일때 가드가 있으므로 4, release일 경우 0으로 처리
+    Node<T>* pNode = reinterpret_cast<Node<T>*>(reinterpret_cast<char*>(ptr) - offsetof(Node<T>, data));
+
+#ifdef _DEBUG 
+    // 스택 오버, 언더 플로우 감지
+    if (
+        pNode->BUFFER_GUARD_FRONT != GUARD_VALUE ||
+        pNode->BUFFER_GUARD_END != GUARD_VALUE
+        )
+    {
+        POOL_TRACE(FreeRejected, this, ptr, POOL_TRACE_REJECT_GUARD);
+
+        // 만약 다르다면 false 반환
+        return false;
+    }
+
+    //  풀 반환이 올바른지 검사
+    if (pNode->POOL_INSTANCE_VALUE != reinterpret_cast<ULONG_PTR>(this))
+    {
+        // 이 시점에서 어떻게 할지... 나중에 결정.
+        POOL_TRACE(FreeRejected, this, ptr, POOL_TRACE_REJECT_POOL);
+
+        // 만약 다르다면 false 반환
+        return false;
+    }
+#endif // _DEBUG
+
+    // 만약 placement new 옵션이 켜져 있다면, 재사용시 placement new로 했을 것이므로 해당 객체의 소멸자를 수동으로 호출
+    if constexpr (bPlacementNew)
+    {
+        pNode->data.~T();
+    }
+
+    // 매거진을 쓰는 풀이라면 스레드 캐시에 넣고, 가득 찼다면 절반을 공유 free list로 넘김
+    if (m_poolId != 0)
+    {
+        Magazine* mag = GetMagazine();
+        if (mag->count == MAGAZINE_SIZE)
+        {
+            FlushMagazine(mag, MAGAZINE_BATCH);
+        }
+
+        mag->nodes[mag->count++] = pNode;
+        POOL_TRACE(Free, this, ptr, POOL_TRACE_SOURCE_MAGAZINE);
+        return true;
+    }
+
+    POOL_TRACE(Free, this, ptr, POOL_TRACE_SOURCE_SHARED);
+
+    // 노드 하나짜리 체인으로 push
+    PushChain(pNode, pNode, 1);
+    MaybeTrim();
+
+    // 반환 성공
+    return true;
+}
+
+template<typename T, bool bPlacementNew>
+inline void MemoryPool<T, bPlacementNew>::AllocBulk(T** out, size_t n)
+{
+    size_t filled = 0;
+
+    while (filled < n)
+    {
+        size_t remain = n - filled;
+        UINT32 want = (remain > UINT32_MAX) ? UINT32_MAX : static_cast<UINT32>(remain);
+
+        // free list에서 남은 갯수만큼 한 번에 떼어내고, 모자라면 다음 루프에서 다시 시도
+        Node<T>* pNode = nullptr;
+        UINT32 count = TakeChain(pNode, want);
+
+        for (UINT32 i = 0; i < count; i++)
+        {
+            // 침투형 배치에서는 생성자가 next를 덮으므로 다음 노드를 먼저 읽어 둠
+            Node<T>* nextNode = (i + 1 < count) ? AddressConverter<T>::ExtractNode(pNode->next) : nullptr;
+
+            if constexpr (bPlacementNew)
+            {
+                new (&(pNode->data)) T();
+            }
+
+            POOL_TRACE(Alloc, this, &pNode->data, POOL_TRACE_SOURCE_SHARED);
+            out[filled++] = &pNode->data;
+
+            pNode = nextNode;
+        }
+    }
+}
+
+template<typename T, bool bPlacementNew>
+inline bool MemoryPool<T, bPlacementNew>::FreeBulk(T** in, size_t n)
+{
+    if (n == 0)
+        return true;
+
+#ifdef _DEBUG
+    // 하나라도 잘못된 포인터가 섞여 있다면 아무것도 반환하지 않고 실패
+    for (size_t i = 0; i < n; i++)
+    {
+        if (in[i] == nullptr)
+            return false;
+
+        Node<T>* pNode = reinterpret_cast<Node<T>*>(reinterpret_cast<char*>(in[i]) - offsetof(Node<T>, data));
+        if (
+            pNode->BUFFER_GUARD_FRONT != GUARD_VALUE ||
+            pNode->BUFFER_GUARD_END != GUARD_VALUE ||
+            pNode->POOL_INSTANCE_VALUE != reinterpret_cast<ULONG_PTR>(this)
+            )
+        {
+            return false;
+        }
+    }
+#endif // _DEBUG
+
+    // 로컬에서 노드끼리 미리 연결해두고, 주인 샤드가 바뀌거나 UINT32 범위를 넘을 때마다 잘라서 게시
+    Node<T>* first = nullptr;
+    Node<T>* last = nullptr;
+    UINT32 count = 0;
+    UINT32 shard = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        Node<T>* pNode = reinterpret_cast<Node<T>*>(reinterpret_cast<char*>(in[i]) - offsetof(Node<T>, data));
+
+        if constexpr (bPlacementNew)
+        {
+            pNode->data.~T();
+        }
+
+        POOL_TRACE(Free, this, in[i], POOL_TRACE_SOURCE_SHARED);
+
+        UINT32 home = HomeShard(pNode);
+        if (count > 0 && (home != shard || count == UINT32_MAX))
+        {
+            PushChain(first, last, count);
+            count = 0;
+        }
+
+        if (count == 0)
+        {
+            first = pNode;
+            shard = home;
+        }
+        else
+        {
+            last->next = reinterpret_cast<UINT64>(pNode);
+        }
+
+        last = pNode;
+        count++;
+    }
+
+    PushChain(first, last, count);
+
+    MaybeTrim();
+
+    return true;
+}
+
+template<typename T, bool bPlacementNew>
+inline size_t MemoryPool<T, bPlacementNew>::Trim(size_t keep)
+{
+    std::lock_guard<std::mutex> lk(m_trimLock);
+    return TrimLocked(keep);
+}
+
+template<typename T, bool bPlacementNew>
+inline size_t MemoryPool<T, bPlacementNew>::TrimLocked(size_t keep)
+{
+    // 모든 샤드의 공유 free list를 통째로 떼어옴. 떼어낸 노드는 이 스레드만 접근하므로 슬랩별로 모아볼 수 있음
+    // 목록을 따라가며 떼어내면 그 사이 들어오는 Push 때문에 처음부터 다시 따라가야 하므로, top만 한 번에 바꾸고 따라가는 것은 떼어낸 뒤에 함
+    // 다시 게시할 때까지 비어 보이는 free list 때문에 Alloc이 슬랩을 새로 만들지 않도록 m_bTrimDetached를 켜 둠 (PopChain에서 기다림)
+    m_bTrimDetached.store(true, std::memory_order_seq_cst);
+
+    std::vector<Node<T>*> nodes;
+    std::vector<UINT32> nodeShard;
+    for (UINT32 shard = 0; shard < m_shardCount; shard++)
+    {
+        for (Node<T>* pNode = m_shards[shard].freeList.PopAll(); pNode; pNode = AddressConverter<T>::ExtractNode(pNode->next))
+        {
+            nodes.push_back(pNode);
+            nodeShard.push_back(shard);
+        }
+    }
+
+    size_t count = nodes.size();
+    if (count == 0)
+    {
+        m_bTrimDetached.store(false, std::memory_order_seq_cst);
+        return 0;
+    }
+
+    m_curPoolCount.Sub(static_cast<LONG64>(count));
+
+    // 떼어낸 노드가 모두 속한 슬랩 목록도 통째로 떼어옴. 그 사이 새로 만들어지는 슬랩은 비어 있는 목록에 쌓임
+    std::vector<SlabHeader*> slabs;
+    if (count > keep)
+    {
+        for (SlabHeader* slab = m_slabList.exchange(nullptr, std::memory_order_acq_rel); slab; slab = slab->next)
+        {
+            slabs.push_back(slab);
+        }
+        std::sort(slabs.begin(), slabs.end(), std::less<SlabHeader*>());
+    }
+
+    // 노드마다 속한 슬랩을 찾아서 슬랩별 free 노드 수를 셈
+    std::vector<UINT32> slabIndex(slabs.empty() ? 0 : count);
+    std::vector<UINT32> freeCount(slabs.size(), 0);
+    for (size_t i = 0; i < slabIndex.size(); i++)
+    {
+        auto it = std::upper_bound(slabs.begin(), slabs.end(), reinterpret_cast<SlabHeader*>(nodes[i]), std::less<SlabHeader*>());
+        slabIndex[i] = static_cast<UINT32>((it - slabs.begin()) - 1);
+        freeCount[slabIndex[i]]++;
+    }
+
+    // 노드가 전부 free list에 있던 슬랩 중에서, 반환해도 keep개 이상 남는 만큼만 고름
+    std::vector<bool> release(slabs.size(), false);
+    size_t remain = count;
+    for (size_t i = 0; i < slabs.size(); i++)
+    {
+        UINT32 nodeCount = slabs[i]->nodeCount;
+        if (freeCount[i] == nodeCount && remain - nodeCount >= keep)
+        {
+            release[i] = true;
+            remain -= nodeCount;
+        }
+    }
+
+    // 남길 노드를 원래 샤드별로 다시 연결해서 샤드마다 한 번의 CAS로 게시
+    for (UINT32 shard = 0; shard < m_shardCount; shard++)
+    {
+        Node<T>* keptFirst = nullptr;
+        Node<T>* keptLast = nullptr;
+        UINT32 keptCount = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (nodeShard[i] != shard || (!slabIndex.empty() && release[slabIndex[i]]))
+                continue;
+
+            if (keptLast)
+                keptLast->next = reinterpret_cast<UINT64>(nodes[i]);
+            else
+                keptFirst = nodes[i];
+
+            keptLast = nodes[i];
+            keptCount++;
+        }
+
+        if (keptCount > 0)
+        {
+            m_shards[shard].freeList.PushChain(keptFirst, keptLast);
+            m_curPoolCount.Add(keptCount);
+        }
+    }
+
+    // 남길 노드를 모두 게시했으므로 기다리던 Alloc을 풀어 줌
+    m_bTrimDetached.store(false, std::memory_order_seq_cst);
+
+    // 남길 슬랩을 다시 연결해서 슬랩 목록 앞에 붙임
+    SlabHeader* keptSlabFirst = nullptr;
+    SlabHeader* keptSlabLast = nullptr;
+    for (size_t i = 0; i < slabs.size(); i++)
+    {
+        if (release[i])
+            continue;
+
+        if (keptSlabLast)
+            keptSlabLast->next = slabs[i];
+        else
+            keptSlabFirst = slabs[i];
+
+        keptSlabLast = slabs[i];
+    }
+
+    if (keptSlabFirst)
+    {
+        SlabHeader* currentHead = m_slabList.load(std::memory_order_relaxed);
+        do {
+            keptSlabLast->next = currentHead;
+        } while (!m_slabList.compare_exchange_weak(currentHead, keptSlabFirst, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // 고른 슬랩의 물리 메모리를 반환. 늦게 따라오는 Pop이 읽을 수 있도록 주소 공간은 유지하고 보관
+    // epoch 회수를 쓴다면 보호 구간에 있는 스레드가 모두 빠져나간 뒤에 주소 공간까지 반환
+    size_t reclaimed = 0;
+    for (size_t i = 0; i < slabs.size(); i++)
+    {
+        if (!release[i])
+            continue;
+
+        UINT32 nodeCount = slabs[i]->nodeCount;
+        size_t bytes = PoolPageRound(SlabBytes<Node<T>>(nodeCount));
+
+        POOL_TRACE(SlabRelease, this, slabs[i], nodeCount);
+
+        // OS가 실제로 돌려받은 바이트만 셈. 아레나의 대형 페이지 청크는 일부 또는 전부를 반환하지 못할 수 있음
+        size_t discarded = bytes;
+#ifdef MEMORYPOOL_EPOCH_RECLAIM
+        if (m_arena == nullptr)
+        {
+            EpochReclaimer::Retire(slabs[i], &PoolPageFree, bytes);
+        }
+        else
+#endif // MEMORYPOOL_EPOCH_RECLAIM
+        {
+            if (m_arena)
+                discarded = m_arena->Release(slabs[i], bytes);
+            else if (!PoolPageDiscard(slabs[i], bytes))
+                discarded = 0;
+
+            m_discardedSlabs.push_back(DiscardedSlab{ slabs[i], nodeCount });
+            m_discardedSlabCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        m_maxPoolCount.Sub(nodeCount);
+        reclaimed += discarded;
+    }
+
+    m_reclaimedBytes.fetch_add(reclaimed, std::memory_order_relaxed);
+    return reclaimed;
+}
+
+template<typename T, bool bPlacementNew>
+inline void MemoryPool<T, bPlacementNew>::SetTrimPolicy(UINT32 highWatermark, UINT32 intervalMs)
+{
+    m_trimIntervalMs = intervalMs;
+    m_aboveWatermarkSinceMs.store(0, std::memory_order_relaxed);
+    m_trimWatermark.store(highWatermark, std::memory_order_release);
+}
+
+template<typename T, bool bPlacementNew>
+inline void MemoryPool<T, bPlacementNew>::MaybeTrim(void)
+{
+    UINT32 watermark = m_trimWatermark.load(std::memory_order_relaxed);
+    if (watermark == 0)
+        return;
+
+    // 카운터 합산과 시각 확인은 비싸므로 가끔만 확인
+    if ((++t_trimTick & (TRIM_CHECK_PERIOD - 1)) != 0)
+        return;
+
+    if (GetCurPoolCount() <= watermark)
+    {
+        m_aboveWatermarkSinceMs.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    // 0은 "넘지 않은 상태"로 쓰므로 시각에 1을 더해서 기록
+    LONG64 now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() + 1;
+    LONG64 since = m_aboveWatermarkSinceMs.load(std::memory_order_relaxed);
+    if (since == 0)
+    {
+        m_aboveWatermarkSinceMs.compare_exchange_strong(since, now, std::memory_order_relaxed);
+        return;
+    }
+
+    if (now - since < static_cast<LONG64>(m_trimIntervalMs))
+        return;
+
+    // 다른 스레드가 이미 Trim 중이라면 기다리지 않음
+    if (m_trimLock.try_lock())
+    {
+        m_aboveWatermarkSinceMs.store(0, std::memory_order_relaxed);
+        TrimLocked(watermark);
+        m_trimLock.unlock();
+    }
+}
+
+
 
-    tlsNode() = default;
-};
 
 
-#ifdef _DEBUG
-#pragma pop
-#endif // _DEBUG
 
-template<typename T>
-struct AddressConverter {
-    static constexpr UINT64 POINTER_MASK = 0x00007FFFFFFFFFFF; //  47Ʈ
-    static constexpr UINT64 STAMP_SHIFT = 47;
 
-    //  ּҿ stamp ߰
-    static UINT64 AddStamp(Node<T>* node, UINT64 stamp) {
-        UINT64 pointerValue = reinterpret_cast<UINT64>(node);
-        return (pointerValue & POINTER_MASK) | (stamp << STAMP_SHIFT);
-    }
-    static UINT64 AddStamp(tlsNode<T>* node, UINT64 stamp) {
-        UINT64 pointerValue = reinterpret_cast<UINT64>(node);
-        return (pointerValue & POINTER_MASK) | (stamp << STAMP_SHIFT);
-    }
 
-    //  ּ 
-    static Node<T>* ExtractNode(UINT64 taggedPointer) {
-        return reinterpret_cast<Node<T>*>(taggedPointer & POINTER_MASK);
-    }
-    static tlsNode<T>* ExtractTLSNode(UINT64 taggedPointer) {
-        return reinterpret_cast<tlsNode<T>*>(taggedPointer & POINTER_MASK);
-    }
-};
 
-#define CAS(target, expected, desired) (InterlockedCompareExchange64(reinterpret_cast<LONG64*>(target), desired, expected) == (expected))
-
-//bool CAS(UINT64* target, UINT64 expected, UINT64 desired) {
-//    return InterlockedCompareExchange64(reinterpret_cast<LONG64*>(target), desired, expected) == expected;
-//}
-
-
-////   
-//queue.enqueue(DebugNode{
-//    reinterpret_cast<long long>(pNode),
-//    reinterpret_cast<long long>(pNewNode),
-//    ACTION::PUSH,
-//    GetCurrentThreadId(),
-//    casSuccess,
-//    GetTickCount64()
-//    });
-
-//enum class ACTION {
-//    ALLOC,
-//    FREE,
-//    END
-//};
-
-//typedef struct _tagDebugNode {
-//    long long pNode;        //   
-//    long long pNext;        //   
-//    ACTION action;          //   (PUSH, POP)
-//    DWORD threadId;         //  ID
-//    bool casSuccess;        // CAS  
-//    unsigned long long timestamp;    // Ÿӽ (и)
-//
-//    _tagDebugNode() {}
-//    _tagDebugNode(long long a, long long b, ACTION _action, DWORD _threadId, bool _success, unsigned long long _timestamp)
-//        : pNode{ a }, pNext{ b }, action{ _action }, threadId{ _threadId }, casSuccess{ _success }, timestamp{ _timestamp } {}
-//} DebugNode, * PDebugNode;
-
-
-// MemoryPool Ŭ 
+// 주인 스레드가 끝난 뒤 입양을 기다리며 보관할 힙의 최대 갯수 (밖에 나가 있는 노드가 있는 힙은 갯수와 상관없이 보관)
+#define TLS_POOL_DEPOT_MAX 16
+
+
+// tlsMemoryPool의 실제 상태(free list, 슬랩, 카운터). 노드의 ownerPool(침투형 배치에서는 세그먼트 헤더의 owner)은 이 객체를 가리킴
+// tlsMemoryPool이 스레드와 함께 소멸해도 이 객체는 해제하지 않고 depot으로 옮김
+// 그래서 다른 스레드에 남아 있던 객체가 늦게 Free되어도 ownerPool이 살아 있고, 새 스레드는 이 힙을 입양해서 malloc 없이 재사용함
 template<typename T, bool bPlacementNew>
-class MemoryPool
+class tlsPoolHeap
 {
+    // 침투형 배치에서는 free list에 있는 노드의 앞 8바이트가 next로 덮임
+    // bPlacementNew = false 는 슬랩을 만들 때 한 번 생성한 객체를 Free/Alloc 사이에 그대로 재사용하므로, 덮인 8바이트가 다음 Alloc에 쓰레기 값으로 남음
+    // 복사 가능한(trivially copyable) 타입이라도 값이 깨지는 것은 같으므로 bPlacementNew 만 허용
+    static_assert(!POOL_INTRUSIVE_NODE || bPlacementNew,
+        "MEMORYPOOL_INTRUSIVE_LAYOUT requires bPlacementNew for tlsMemoryPool (use PoolRawStorage<T> for raw storage)");
+
 public:
-    // 
-    MemoryPool(UINT32 sizeInitialize = 0);
+    // 생성자
+    // slabNodeCount : 풀이 비었을 때 한 번에 할당할 노드 갯수, 0이면 페이지 크기에 맞춰 결정
+    // arena : 슬랩을 잘라 올 아레나, nullptr이면 malloc
+    tlsPoolHeap(UINT32 sizeInitialize = 0, UINT32 slabNodeCount = 0, SlabArena* arena = nullptr);
 
-    // Ҹ
-    virtual ~MemoryPool(void);
+    // 소멸자. 모든 노드가 돌아온 힙만 해제하므로 Orphan에서만 호출됨
+    virtual ~tlsPoolHeap(void);
+
+    // depot에 있는 주인 없는 힙 중 같은 아레나를 쓰는 힙을 하나 가져오거나 새로 만듦
+    static tlsPoolHeap* Adopt(UINT32 slabNodeCount, SlabArena* arena);
+
+    // 주인 스레드가 끝날 때 호출. 힙을 depot에 맡기고, depot이 가득 찼는데 모든 노드가 돌아와 있다면 해제
+    static void Orphan(tlsPoolHeap* heap);
+
+    // free list에 최소 count개의 노드가 있도록 모자란 만큼 슬랩 하나로 채움
+    void Reserve(UINT32 count);
 
-    // Ǯ ִ ü Ѱְų  Ҵ ѱ
+    // 풀에 있는 객체를 넘겨주거나 새로 할당해 넘김
     T* Alloc(void);
 
-    // ü Ǯ ȯ
+    // 객체를 풀에 반환
     bool Free(T* ptr);
 
-public:
-    UINT32 GetCurPoolCount(void) { return InterlockedCompareExchange(&m_curPoolCount, 0, 0); }
-    UINT32 GetMaxPoolCount(void) { return InterlockedCompareExchange(&m_maxPoolCount, 0, 0); }
+    // 객체 n개를 한 번에 할당해 out에 채움. free list에서 체인을 한 번의 CAS로 떼어냄
+    void AllocBulk(T** out, size_t n);
+
+    // 객체 n개를 한 번에 반환. 주인 풀이 같은 연속 구간끼리 연결해서 한 번의 CAS로 게시
+    bool FreeBulk(T** in, size_t n);
 
 public:
-    //Node<T>* m_freeNode;
-    UINT32 m_curPoolCount; // Ǯ ϴ  , AllocǸ 1 , FreeǸ 1 
-    UINT32 m_maxPoolCount; // Ǯ ϴ ִ  
+    // 카운터는 샤드로 나뉘어 있어서 읽을 때만 합산함. 측정 중인 값이므로 근사값
+    UINT32 GetCurPoolCount(void) { LONG64 count = m_curPoolCount.Load(); return count > 0 ? static_cast<UINT32>(count) : 0; }
+    UINT32 GetMaxPoolCount(void) { LONG64 count = m_maxPoolCount.Load(); return count > 0 ? static_cast<UINT32>(count) : 0; }
+    UINT32 GetSlabNodeCount(void) { return m_slabNodeCount; }
 
 private:
-    UINT64 top; // Top Ÿ tagged pointer, Node<T>* m_freeNode ٲ 
-    UINT64 stamp; //  Ǵ stamp 
+    // count개의 노드를 담은 슬랩을 할당해 슬랩 목록에 등록
+    // new로 노드를 만들던 때와 같이 메모리를 받아오지 못하면 std::bad_alloc
+    SlabHeader* AllocSlab(UINT32 count);
 
-    //public:
-    //    CircularQueue<DebugNode> debugQueue;
-};
+    // first ~ last로 이미 연결된 노드 count개를 한 번의 CAS로 free list에 게시
+    void PushChain(tlsNode<T>* first, tlsNode<T>* last, UINT32 count);
 
-template<typename T, bool bPlacementNew>
-inline MemoryPool<T, bPlacementNew>::MemoryPool(UINT32 sizeInitialize)
-{
-    top = 0;
-    m_curPoolCount = 0;
-    m_maxPoolCount = 0;
-    stamp = 0;
+    // free list의 top부터 최대 maxCount개의 노드를 한 번의 CAS로 떼어내고 갯수를 반환
+    // 떼어낸 노드들은 first부터 next로 연결된 상태
+    UINT32 PopChain(tlsNode<T>*& first, UINT32 maxCount);
+
+    // 노드 count개를 연결된 체인으로 확보. free list가 비었다면 슬랩을 새로 할당하고 남는 노드는 free list에 게시
+    UINT32 TakeChain(tlsNode<T>*& first, UINT32 count);
+
+    // 다른 스레드가 반환한 first ~ last 체인을 이 풀의 remote free list에 게시 (주인이 아닌 스레드가 호출)
+    void PushRemote(tlsNode<T>* first, tlsNode<T>* last);
 
-    T** pArr = new T * [sizeInitialize];
+    // remote free list를 통째로 떼어내 free list로 옮기고 옮긴 갯수를 반환 (주인 스레드가 free list가 비었을 때 호출)
+    UINT32 DrainRemote(void);
 
-    // ʱ ޸  غ
-    if (sizeInitialize > 0)
+    // 노드 배치에 따른 슬랩 구성. 침투형 배치에서는 슬랩이 세그먼트로 나뉘고 주인 풀은 세그먼트 헤더에 있음
+#if POOL_INTRUSIVE_NODE
+    static tlsNode<T>* SlabNodeAt(SlabHeader* slab, UINT32 index) { return SegmentSlabNode<tlsNode<T>>(slab, index); }
+    static size_t SlabSize(UINT32 count) { return SegmentSlabBytes<tlsNode<T>>(count); }
+    static UINT32 DefaultNodeCount(void) { return SegmentNodeCount<tlsNode<T>>(); }
+    static tlsPoolHeap* OwnerOf(tlsNode<T>* node) { return reinterpret_cast<tlsPoolHeap*>(SegmentOf(node)->owner); }
+#else
+    static tlsNode<T>* SlabNodeAt(SlabHeader* slab, UINT32 index) { return SlabNode<tlsNode<T>>(slab, index); }
+    static size_t SlabSize(UINT32 count) { return SlabBytes<tlsNode<T>>(count); }
+    static UINT32 DefaultNodeCount(void) { return DefaultSlabNodeCount<tlsNode<T>>(); }
+    static tlsPoolHeap* OwnerOf(tlsNode<T>* node) { return reinterpret_cast<tlsPoolHeap*>(node->ownerPool); }
+#endif // POOL_INTRUSIVE_NODE
+
+    // 주인 스레드가 끝난 힙 보관소
+    struct HeapDepot
     {
-        for (UINT32 i = 0; i < sizeInitialize; i++)
-        {
-            pArr[i] = Alloc();
-        }
+        std::mutex lock;
+        std::vector<tlsPoolHeap*> heaps;
+    };
 
-        for (UINT32 i = 0; i < sizeInitialize; i++)
-        {
-            Free(pArr[i]);
-        }
+    // 정적 객체 소멸 순서에 휘말리지 않도록 일부러 해제하지 않음
+    static HeapDepot& GetDepot(void)
+    {
+        static HeapDepot* depot = new HeapDepot;
+        return *depot;
     }
 
-    delete[] pArr;
-}
+private:
+    //tlsNode<T>* m_freeNode;
+    POOL_CACHE_ALIGN TaggedFreeList<tlsNode<T>> m_freeList; // 반환된 노드 스택, tlsNode<T>* m_freeNode가 바뀐 형태
+
+    // 통계용 카운터. 스레드별 샤드에 나눠 더하므로 Alloc/Free마다 같은 캐시 라인을 두고 경쟁하지 않음
+    ShardedCounter m_curPoolCount; // 풀에서 사용하는 노드 갯수, Alloc되면 1 감소, Free되면 1 증가
+    ShardedCounter m_maxPoolCount; // 풀에서 사용하는 최대 노드 갯수
+
+    // 다른 스레드가 반환한 노드 스택 (MPSC). 여러 스레드가 push하고 주인 스레드만 통째로 떼어가므로 ABA가 없어 tag가 필요 없음
+    // 주인의 free list와 다른 캐시 라인에 두어 주인의 Alloc/Free 경로에 다른 스레드가 쓰지 않도록 함
+    // 여기 있는 노드는 DrainRemote로 옮겨지기 전까지 m_curPoolCount에 포함되지 않음
+    POOL_CACHE_ALIGN std::atomic<tlsNode<T>*> m_remoteFree;
+
+    // 이하 자주 바뀌지 않는 필드
+    POOL_CACHE_ALIGN std::atomic<SlabHeader*> m_slabList; // 할당한 슬랩 목록. 소멸자에서 슬랩 단위로 해제
+    UINT32 m_slabNodeCount; // 풀이 비었을 때 한 번에 할당할 노드 갯수
+    SlabArena* m_arena;     // 슬랩을 잘라 올 아레나, nullptr이면 malloc
+};
 
 template<typename T, bool bPlacementNew>
-inline MemoryPool<T, bPlacementNew>::~MemoryPool(void)
+inline tlsPoolHeap<T, bPlacementNew>::tlsPoolHeap(UINT32 sizeInitialize, UINT32 slabNodeCount, SlabArena* arena)
 {
-    Node<T>* currentNode;
-    UINT64 nextNode;
-    UINT64 currentTop;
-    UINT64 newTop;
-    UINT64 stValue = InterlockedIncrement(&stamp);
 
-    while (true) {
-        currentTop = top;
-        currentNode = AddressConverter<T>::ExtractNode(currentTop);
+    m_slabList = nullptr;
+    m_arena = arena;
+    m_remoteFree = nullptr;
+    m_slabNodeCount = (slabNodeCount == 0) ? DefaultNodeCount() : slabNodeCount;
 
-        if (!currentNode) {
-            //   
-            break;
-        }
+    // 초기 메모리 공간 준비. 요청한 갯수만큼 슬랩 하나로 잡아서 통째로 free list에 넣음
+    Reserve(sizeInitialize);
+}
 
-        nextNode = currentNode->next;
+template<typename T, bool bPlacementNew>
+inline tlsPoolHeap<T, bPlacementNew>::~tlsPoolHeap(void)
+{
+    // 다른 스레드가 반환해 둔 노드도 free list로 옮김
+    DrainRemote();
 
-        if (CAS(&top, currentTop, nextNode)) {
-            delete currentNode;
-            InterlockedDecrement(&m_maxPoolCount);
+    // placement new를 쓰지 않는 풀은 노드를 만들 때 생성자를 호출했으므로 여기서 소멸자 호출
+    if constexpr (!bPlacementNew)
+    {
+        tlsNode<T>* currentNode = m_freeList.Head();
+        while (currentNode)
+        {
+            currentNode->data.~T();
+            currentNode = AddressConverter<T>::ExtractTLSNode(currentNode->next);
         }
     }
 
-    //  Ҵ   Ϸ ʾҴٸ
-    if (m_maxPoolCount != 0)
+    // 노드를 하나씩 지우지 않고 슬랩 단위로 해제
+    SlabHeader* slab = m_slabList.load(std::memory_order_acquire);
+    while (slab)
     {
-        // ...  ߿ ڱ.
+        SlabHeader* nextSlab = slab->next;
+        if (m_arena)
+        {
+            m_arena->Release(slab, SlabSize(slab->nodeCount));
+        }
+        else
+        {
+#if POOL_INTRUSIVE_NODE
+            PoolPageFree(slab, SlabSize(slab->nodeCount));
+#else
+            if constexpr (SlabAlign<tlsNode<T>>() > alignof(std::max_align_t))
+                ::operator delete(slab, std::align_val_t(SlabAlign<tlsNode<T>>()));
+            else
+                free(slab);
+#endif // POOL_INTRUSIVE_NODE
+        }
+        slab = nextSlab;
     }
+
+    m_slabList.store(nullptr, std::memory_order_relaxed);
+    m_freeList.Clear();
+    m_curPoolCount.Reset();
+    m_maxPoolCount.Reset();
 }
 
-//  ִٸ Ҵ, ִٸ popϰ ȯε...
 template<typename T, bool bPlacementNew>
-inline T* MemoryPool<T, bPlacementNew>::Alloc(void)
+inline tlsPoolHeap<T, bPlacementNew>* tlsPoolHeap<T, bPlacementNew>::Adopt(UINT32 slabNodeCount, SlabArena* arena)
 {
-    Node<T>* currentNode;
-    UINT64 nextNode;
-    UINT64 currentTop;
-    UINT64 newTop;
-    UINT64 stValue = InterlockedIncrement(&stamp);
-
-    while (true) {
-        currentTop = top;
-        currentNode = AddressConverter<T>::ExtractNode(currentTop);
-
-        //   ִٸ  带 ؼ ȯ
-        if (!currentNode) {
-            // m_freeNode nullptr̶ Ǯ ü  ʴ´ٴ ǹ̹Ƿ ο ü Ҵ
-
-            //   Ҵ
-            Node<T>* newNode = (Node<T>*)malloc(sizeof(Node<T>));
-            ZeroMemory(newNode, sizeof(T));
-
-#ifdef _DEBUG
-            //  .   Ȯϰ, ȯǴ Ǯ  ùٸ Ȯϱ  
-            newNode->BUFFER_GUARD_FRONT = GUARD_VALUE;
-            newNode->BUFFER_GUARD_END = GUARD_VALUE;
-
-            newNode->POOL_INSTANCE_VALUE = reinterpret_cast<ULONG_PTR>(this);
-#endif // _DEBUG
-
-            newNode->next = 0;      // Ȯ m_freeNode ص ȴ. ٵ  ü nullptr̴   nullptr .
-            //  0 ʱȭ
+    tlsPoolHeap* heap = nullptr;
 
-
-            // ó ڸ ȣ -> tlsMemoryPool̶ ٸ κε ߿  ʿ.   𸣰ڴ.
-            if constexpr (bPlacementNew)
+    {
+        HeapDepot& depot = GetDepot();
+        std::lock_guard<std::mutex> guard(depot.lock);
+        for (size_t i = depot.heaps.size(); i > 0; i--)
+        {
+            if (depot.heaps[i - 1]->m_arena == arena)
             {
-                //new (reinterpret_cast<char*>(newNode) + offsetof(Node<T>, data)) T();
-                new (&(newNode->data)) T();
+                heap = depot.heaps[i - 1];
+                depot.heaps.erase(depot.heaps.begin() + (i - 1));
+                break;
             }
-
-            // Ǯ ϴ ִ   1 
-            InterlockedIncrement(&m_maxPoolCount);
-
-            // ü TŸ  ȯ
-            return reinterpret_cast<T*>(reinterpret_cast<char*>(newNode) + offsetof(Node<T>, data));
         }
+    }
 
-        nextNode = currentNode->next;
+    if (heap == nullptr)
+    {
+        return new tlsPoolHeap(0, slabNodeCount, arena);
+    }
 
-        if (CAS(&top, currentTop, nextNode)) {
+    // 입양한 스레드가 새 주인. 주인이 없는 동안 remote free list에 쌓인 노드를 가져옴
+    heap->m_slabNodeCount = (slabNodeCount == 0) ? DefaultNodeCount() : slabNodeCount;
+    heap->DrainRemote();
 
-            //  placement New ɼ ִٸ  ȣ
-            if constexpr (bPlacementNew)
-            {
-                //new (reinterpret_cast<char*>(returnNode) + offsetof(Node<T>, data)) T();
-                new (&(currentNode->data)) T();
-            }
+    return heap;
+}
+
+template<typename T, bool bPlacementNew>
+inline void tlsPoolHeap<T, bPlacementNew>::Orphan(tlsPoolHeap* heap)
+{
+    heap->DrainRemote();
 
-            // Ǯ ϴ   1 
-            InterlockedDecrement(&m_curPoolCount);
+    // 밖에 나가 있는 노드가 있다면 늦게 들어올 Free를 받아야 하므로 반드시 depot에 보관
+    // 모두 돌아와 있다면 누구도 이 힙을 참조하지 않으므로 depot이 가득 찼을 때는 해제해도 안전
+    bool bOutstanding = heap->GetCurPoolCount() != heap->GetMaxPoolCount();
 
-            // ü TŸ  ȯ
-            return &currentNode->data;
+    {
+        HeapDepot& depot = GetDepot();
+        std::lock_guard<std::mutex> guard(depot.lock);
+        if (bOutstanding || depot.heaps.size() < TLS_POOL_DEPOT_MAX)
+        {
+            depot.heaps.push_back(heap);
+            return;
         }
     }
+
+    delete heap;
 }
 
 template<typename T, bool bPlacementNew>
-inline bool MemoryPool<T, bPlacementNew>::Free(T* ptr)
+inline void tlsPoolHeap<T, bPlacementNew>::Reserve(UINT32 count)
 {
-#ifdef _DEBUG
-    // ȯϴ   ʴ´ٸ
-    if (ptr == nullptr)
-    {
-        // 
-        return false;
-    }
-#endif // _DEBUG
+    UINT32 curCount = GetCurPoolCount();
+    if (curCount >= count)
+        return;
 
-    // offsetof(Node<T>, data)) => Node ü data  Node ü ּ ̰ 
-    // ⼱ debug ϶ 尡 Ƿ 4, release  0 ó
-    Node<T>* pNode = reinterpret_cast<Node<T>*>(reinterpret_cast<char*>(ptr) - offsetof(Node<T>, data));
+    UINT32 need = count - curCount;
+    SlabHeader* slab = AllocSlab(need);
+    PushChain(SlabNodeAt(slab, 0), SlabNodeAt(slab, need - 1), need);
+}
 
-#ifdef _DEBUG 
-    //  ,  ÷ο 
-    if (
-        pNode->BUFFER_GUARD_FRONT != GUARD_VALUE ||
-        pNode->BUFFER_GUARD_END != GUARD_VALUE
-        )
+template<typename T, bool bPlacementNew>
+inline SlabHeader* tlsPoolHeap<T, bPlacementNew>::AllocSlab(UINT32 count)
+{
+    // 헤더 + 노드 count개를 하나의 연속된 블록으로 할당
+    // 아레나에서 받은 메모리는 이미 0으로 채워져 있음
+    SlabHeader* slab;
+#if POOL_INTRUSIVE_NODE
+    // 주소 마스킹으로 세그먼트 헤더를 찾을 수 있도록 세그먼트 크기 경계에 맞춰 받아옴 (PoolPageAllocAligned도 0으로 채워져 있음)
+    if (m_arena)
+        slab = (SlabHeader*)m_arena->Allocate(SlabSize(count), SegmentSize<tlsNode<T>>());
+    else
+        slab = (SlabHeader*)PoolPageAllocAligned(SlabSize(count), SegmentSize<tlsNode<T>>());
+
+    if (slab == nullptr)
     {
-        //  ٸٸ false ȯ
-        return false;
+        throw std::bad_alloc();
     }
 
-    //  Ǯ ȯ ùٸ ˻
-    if (pNode->POOL_INSTANCE_VALUE != reinterpret_cast<ULONG_PTR>(this))
+    for (size_t offset = 0; offset < SlabSize(count); offset += SegmentSize<tlsNode<T>>())
     {
-        //    ... ߿ .
-
-
-        //  ٸٸ false ȯ
-        return false;
+        reinterpret_cast<SlabSegmentHeader*>(reinterpret_cast<char*>(slab) + offset)->owner = this;
     }
-#endif // _DEBUG
-
-    //  placement new ɼ  ִٸ,  placement new  ̹Ƿ ش ü Ҹڸ  ȣ
-    if constexpr (bPlacementNew)
+#else
+    // malloc은 max_align_t까지만 보장하므로 정렬이 더 큰 노드는 정렬을 지정해서 받음
+    if (m_arena)
     {
-        pNode->data.~T();
+        slab = (SlabHeader*)m_arena->Allocate(SlabSize(count), SlabAlign<tlsNode<T>>());
+        if (slab == nullptr)
+        {
+            throw std::bad_alloc();
+        }
     }
+    else
+    {
+        if constexpr (SlabAlign<tlsNode<T>>() > alignof(std::max_align_t))
+            slab = (SlabHeader*)::operator new(SlabSize(count), std::align_val_t(SlabAlign<tlsNode<T>>()));
+        else
+            slab = (SlabHeader*)malloc(SlabSize(count));
 
-    Node<T>* currentNode;
-
-    UINT64 stValue = InterlockedIncrement(&stamp);
-    UINT64 currentTop;
-    UINT64 newTop;
-
-    newTop = AddressConverter<T>::AddStamp(pNode, stValue);
-
-    while (true) {
-        currentTop = top;
-
-        pNode->next = currentTop; // ο  next  top 
-
-        if (CAS(&top, currentTop, newTop)) {
-            break; //  Push Ϸ
+        // 정렬을 지정한 operator new는 실패하면 이미 std::bad_alloc을 던지므로 malloc만 해당
+        if (slab == nullptr)
+        {
+            throw std::bad_alloc();
         }
+        memset(slab, 0, SlabSize(count));
     }
+#endif // POOL_INTRUSIVE_NODE
 
-    // Ǯ ϴ   1 
-    InterlockedIncrement(&m_curPoolCount);
+    slab->nodeCount = count;
 
-    // ȯ 
-    return true;
-}
+    // 슬랩 안의 노드들을 미리 서로 연결. 마지막 노드의 next는 게시할 때 채움
+    for (UINT32 i = 0; i < count; i++)
+    {
+        tlsNode<T>* newNode = SlabNodeAt(slab, i);
+
+        // placement new를 쓰지 않는 풀은 노드를 만들 때 한 번만 생성자를 호출
+        // 침투형 배치에서는 next가 객체 공간과 겹치므로 next를 채우기 전에 생성
+        if constexpr (!bPlacementNew)
+        {
+            new (&(newNode->data)) T();
+        }
 
+#if !POOL_INTRUSIVE_NODE
+        newNode->ownerPool = this;
+#endif // !POOL_INTRUSIVE_NODE
 
+#ifdef _DEBUG
+        // 디버깅용 가드. 가드 값도 확인하고, 반환되는 풀의 정보가 올바른지 확인하기 위해 사용
+        newNode->BUFFER_GUARD_FRONT = GUARD_VALUE;
+        newNode->BUFFER_GUARD_END = GUARD_VALUE;
 
+        newNode->POOL_INSTANCE_VALUE = reinterpret_cast<ULONG_PTR>(this);
+#endif // _DEBUG
 
+        newNode->next = (i + 1 < count) ? reinterpret_cast<UINT64>(SlabNodeAt(slab, i + 1)) : 0;
+    }
 
+    // 슬랩 목록에 등록. 다른 스레드의 Free와 겹칠 수 있으므로 CAS로 연결
+    SlabHeader* currentHead;
+    currentHead = m_slabList.load(std::memory_order_relaxed);
+    do {
+        slab->next = currentHead;
+    } while (!m_slabList.compare_exchange_weak(currentHead, slab, std::memory_order_release, std::memory_order_relaxed));
 
+    // 풀에서 사용하는 최대 노드 갯수를 슬랩 크기만큼 증가
+    m_maxPoolCount.Add(count);
 
+    POOL_TRACE(SlabAlloc, this, slab, count);
 
+    return slab;
+}
 
-// MemoryPool Ŭ 
 template<typename T, bool bPlacementNew>
-class tlsMemoryPool
+inline void tlsPoolHeap<T, bPlacementNew>::PushChain(tlsNode<T>* first, tlsNode<T>* last, UINT32 count)
 {
-public:
-    // 
-    tlsMemoryPool(UINT32 sizeInitialize = 0);
-
-    // Ҹ
-    virtual ~tlsMemoryPool(void);
+    POOL_TRACE(PushChain, this, first, count);
 
-    // Ǯ ִ ü Ѱְų  Ҵ ѱ
-    T* Alloc(void);
-
-    // ü Ǯ ȯ
-    bool Free(T* ptr);
+    m_freeList.PushChain(first, last);
 
-public:
-    UINT32 GetCurPoolCount(void) { return InterlockedCompareExchange(&m_curPoolCount, 0, 0); }
-    UINT32 GetMaxPoolCount(void) { return InterlockedCompareExchange(&m_maxPoolCount, 0, 0); }
+    // 풀에 존재하는 노드 갯수를 count만큼 증가
+    m_curPoolCount.Add(count);
+}
 
-public:
-    //tlsNode<T>* m_freeNode;
-    UINT32 m_curPoolCount; // Ǯ ϴ  , AllocǸ 1 , FreeǸ 1 
-    UINT32 m_maxPoolCount; // Ǯ ϴ ִ  
+template<typename T, bool bPlacementNew>
+inline UINT32 tlsPoolHeap<T, bPlacementNew>::PopChain(tlsNode<T>*& first, UINT32 maxCount)
+{
+    UINT32 count = m_freeList.PopChain(first, maxCount);
 
-private:
-    UINT64 top; // Top Ÿ tagged pointer, tlsNode<T>* m_freeNode ٲ 
-    UINT64 stamp; //  Ǵ stamp 
+    // 풀에 존재하는 노드 갯수를 count만큼 감소
+    if (count > 0)
+    {
+        m_curPoolCount.Sub(count);
+        POOL_TRACE(PopChain, this, first, count);
+    }
 
-    //public:
-    //    CircularQueue<DebugNode> debugQueue;
-};
+    return count;
+}
 
 template<typename T, bool bPlacementNew>
-inline tlsMemoryPool<T, bPlacementNew>::tlsMemoryPool(UINT32 sizeInitialize)
+inline UINT32 tlsPoolHeap<T, bPlacementNew>::TakeChain(tlsNode<T>*& first, UINT32 count)
 {
-    if (sizeInitialize == 0)
-        return;
+    UINT32 popped = PopChain(first, count);
+    if (popped > 0)
+        return popped;
 
-    top = 0;
-    m_curPoolCount = 0;
-    m_maxPoolCount = 0;
-    stamp = 0;
+    // free list가 비었다면 다른 스레드가 반환한 노드부터 가져옴
+    if (DrainRemote() > 0)
+    {
+        popped = PopChain(first, count);
+        if (popped > 0)
+            return popped;
+    }
 
-    T** pArr = new T * [sizeInitialize];
+    // free list가 비어 있다면 요청한 갯수 이상을 담는 슬랩을 새로 할당
+    UINT32 slabCount = (count > m_slabNodeCount) ? count : m_slabNodeCount;
+    SlabHeader* slab = AllocSlab(slabCount);
 
-    // ʱ ޸  غ
-    if (sizeInitialize > 0)
+    // 앞쪽 count개는 가져가고, 남는 노드는 한 번의 CAS로 free list에 게시
+    if (slabCount > count)
     {
-        for (UINT32 i = 0; i < sizeInitialize; i++)
-        {
-            pArr[i] = Alloc();
-        }
-
-        for (UINT32 i = 0; i < sizeInitialize; i++)
-        {
-            Free(pArr[i]);
-        }
+        PushChain(SlabNodeAt(slab, count), SlabNodeAt(slab, slabCount - 1), slabCount - count);
     }
 
-    delete[] pArr;
+    first = SlabNodeAt(slab, 0);
+    return count;
 }
 
 template<typename T, bool bPlacementNew>
-inline tlsMemoryPool<T, bPlacementNew>::~tlsMemoryPool(void)
+inline void tlsPoolHeap<T, bPlacementNew>::PushRemote(tlsNode<T>* first, tlsNode<T>* last)
 {
-    tlsNode<T>* currentNode;
-    UINT64 nextNode;
-    UINT64 currentTop;
-    UINT64 newTop;
-    UINT64 stValue = InterlockedIncrement(&stamp);
-
-    while (true) {
-        currentTop = top;
-        currentNode = AddressConverter<T>::ExtractTLSNode(currentTop);
-
-        if (!currentNode) {
-            //   
-            break;
-        }
-
-        nextNode = currentNode->next;
-
-        if (CAS(&top, currentTop, nextNode)) {
-            delete currentNode;
-            InterlockedDecrement(&m_maxPoolCount);
-        }
-    }
+    tlsNode<T>* currentHead = m_remoteFree.load(std::memory_order_relaxed);
+    do {
+        last->next = reinterpret_cast<UINT64>(currentHead);
+    } while (!m_remoteFree.compare_exchange_weak(currentHead, first, std::memory_order_release, std::memory_order_relaxed));
+}
 
-    //  Ҵ   Ϸ ʾҴٸ
-    if (m_maxPoolCount != 0)
+template<typename T, bool bPlacementNew>
+inline UINT32 tlsPoolHeap<T, bPlacementNew>::DrainRemote(void)
+{
+    // 비어 있을 때는 exchange로 캐시 라인을 가져오지 않도록 먼저 읽어봄
+    if (m_remoteFree.load(std::memory_order_relaxed) == nullptr)
+        return 0;
+
+    tlsNode<T>* first = m_remoteFree.exchange(nullptr, std::memory_order_acquire);
+    if (first == nullptr)
+        return 0;
+
+    // 끝을 찾으면서 갯수를 셈. 체인은 통째로 한 번의 CAS로 free list에 게시
+    tlsNode<T>* last = first;
+    UINT32 count = 1;
+    while (last->next != 0)
     {
-        DebugBreak();
-        // ...  ߿ ڱ.
+        last = AddressConverter<T>::ExtractTLSNode(last->next);
+        count++;
     }
+
+    PushChain(first, last, count);
+    return count;
 }
 
-//  ִٸ Ҵ, ִٸ popϰ ȯε...
+// 만약 비어있다면 할당, 있다면 pop하고 반환인데...
 template<typename T, bool bPlacementNew>
-inline T* tlsMemoryPool<T, bPlacementNew>::Alloc(void)
+inline T* tlsPoolHeap<T, bPlacementNew>::Alloc(void)
 {
-    tlsNode<T>* currentNode;
-    UINT64 nextNode;
-    UINT64 currentTop;
-    UINT64 newTop;
-    UINT64 stValue = InterlockedIncrement(&stamp);
+    // free list에서 하나를 꺼냄. tag는 top에 들어있던 값을 이어서 증가시키므로 전역 stamp를 건드리지 않음
+    tlsNode<T>* currentNode = m_freeList.Pop();
 
-    while (true) {
-        currentTop = top;
-        currentNode = AddressConverter<T>::ExtractTLSNode(currentTop);
-
-        //   ִٸ  带 ؼ ȯ
-        if (!currentNode) {
-            // m_freeNode nullptr̶ Ǯ ü  ʴ´ٴ ǹ̹Ƿ ο ü Ҵ
+    // 비어 있다면 다른 스레드가 반환해 둔 노드를 한 번에 옮겨와서 다시 시도
+    if (!currentNode && DrainRemote() > 0) {
+        currentNode = m_freeList.Pop();
+    }
 
-            //   Ҵ
-            tlsNode<T>* newNode = (tlsNode<T>*)malloc(sizeof(tlsNode<T>));
-            newNode->ownerPool = this;
-            ZeroMemory(newNode, sizeof(T));
+    // 그래도 비어 있다면 새로 슬랩을 할당해서 반환
+    if (!currentNode) {
+        // m_freeNode가 nullptr이라면 풀에 객체가 존재하지 않는다는 의미이므로 슬랩 단위로 새로 할당
 
-#ifdef _DEBUG
-            //  .   Ȯϰ, ȯǴ Ǯ  ùٸ Ȯϱ  
-            newNode->BUFFER_GUARD_FRONT = GUARD_VALUE;
-            newNode->BUFFER_GUARD_END = GUARD_VALUE;
+        // 노드 하나씩 malloc하지 않고 m_slabNodeCount개를 한 번에 할당
+        SlabHeader* slab = AllocSlab(m_slabNodeCount);
+        tlsNode<T>* newNode = SlabNodeAt(slab, 0);
 
-            newNode->POOL_INSTANCE_VALUE = reinterpret_cast<ULONG_PTR>(this);
-#endif // _DEBUG
+        // 첫 노드는 바로 반환하고, 나머지는 한 번의 CAS로 free list에 게시
+        if (m_slabNodeCount > 1)
+        {
+            PushChain(SlabNodeAt(slab, 1), SlabNodeAt(slab, m_slabNodeCount - 1), m_slabNodeCount - 1);
+        }
 
-            newNode->next = 0;      // Ȯ m_freeNode ص ȴ. ٵ  ü nullptr̴   nullptr .
-            //  0 ʱȭ
+        // 침투형 배치에서는 생성해 둔 객체를 덮지 않도록 건드리지 않음
+#if !POOL_INTRUSIVE_NODE
+        newNode->next = 0;
+#endif // !POOL_INTRUSIVE_NODE
 
-            // ó ڸ ȣ
+        // placement new 옵션이 켜져 있다면 반환할 노드만 생성자 호출 (꺼져 있다면 AllocSlab에서 이미 호출됨)
+        if constexpr (bPlacementNew)
+        {
             new (&(newNode->data)) T(); //new (reinterpret_cast<char*>(newNode) + offsetof(Node<T>, data)) T();
-
-            // Ǯ ϴ ִ   1 
-            InterlockedIncrement(&m_maxPoolCount);
-
-            // ü TŸ  ȯ
-            return reinterpret_cast<T*>(reinterpret_cast<char*>(newNode) + offsetof(tlsNode<T>, data));
         }
 
-        nextNode = currentNode->next;
+        POOL_TRACE(Alloc, this, &newNode->data, POOL_TRACE_SOURCE_NEW_SLAB);
 
-        if (CAS(&top, currentTop, nextNode)) {
+        // 객체의 T타입 데이터 반환
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(newNode) + offsetof(tlsNode<T>, data));
+    }
 
-            //  placement New ɼ ִٸ  ȣ
-            if constexpr (bPlacementNew)
-            {
-                //new (reinterpret_cast<char*>(returnNode) + offsetof(Node<T>, data)) T();
-                new (&(currentNode->data)) T();
-            }
+    // 재사용시 placement New 옵션이 켜져있다면 생성자 호출
+    if constexpr (bPlacementNew)
+    {
+        //new (reinterpret_cast<char*>(returnNode) + offsetof(Node<T>, data)) T();
+        new (&(currentNode->data)) T();
+    }
 
-            // Ǯ ϴ   1 
-            InterlockedDecrement(&m_curPoolCount);
+    // 풀에 존재하는 노드 갯수를 1 감소
+    m_curPoolCount.Sub(1);
 
-            // ü TŸ  ȯ
-            return &currentNode->data;
-        }
-    }
+    POOL_TRACE(Alloc, this, &currentNode->data, POOL_TRACE_SOURCE_SHARED);
+
+    // 객체의 T타입 데이터 반환
+    return &currentNode->data;
 }
 
 template<typename T, bool bPlacementNew>
-inline bool tlsMemoryPool<T, bPlacementNew>::Free(T* ptr)
+inline bool tlsPoolHeap<T, bPlacementNew>::Free(T* ptr)
 {
 #ifdef _DEBUG
-    // ȯϴ   ʴ´ٸ
+    // 반환하는 값이 존재하지 않는다면
     if (ptr == nullptr)
     {
-        // 
+        POOL_TRACE(FreeRejected, this, ptr, POOL_TRACE_REJECT_NULL);
+
+        // 실패
         return false;
     }
 #endif // _DEBUG
 
-    // offsetof(Node<T>, data)) => Node ü data  Node ü ּ ̰ 
-    // ⼱ debug ϶ 尡 Ƿ 4, release  0 ó
+    // offsetof(Node<T>, data)) => Node 구조체의 data 변수와 Node 구조체와의 주소 차이값을 계산
+    // 여기선 debug 모드일때 가드가 있으므로 4, release일 경우 0으로 처리
     tlsNode<T>* pNode = reinterpret_cast<tlsNode<T>*>(reinterpret_cast<char*>(ptr) - offsetof(tlsNode<T>, data));
 
-    // dispatch to ownerPool if different
-    tlsMemoryPool* owner = reinterpret_cast<tlsMemoryPool*>(pNode->ownerPool);
-    if (owner != this) {
-        return owner->Free(ptr);
-    }
+    // 노드를 만든 풀. 다른 스레드의 풀이라면 아래에서 remote free list로 보냄
+    tlsPoolHeap* owner = OwnerOf(pNode);
 
 #ifdef _DEBUG 
-    //  ,  ÷ο 
+    // 스택 오버, 언더 플로우 감지
     if (
         pNode->BUFFER_GUARD_FRONT != GUARD_VALUE ||
         pNode->BUFFER_GUARD_END != GUARD_VALUE
         )
     {
-        //  ٸٸ false ȯ
+        POOL_TRACE(FreeRejected, this, ptr, POOL_TRACE_REJECT_GUARD);
+
+        // 만약 다르다면 false 반환
         return false;
     }
 
-    //  Ǯ ȯ ùٸ ˻
-    if (pNode->POOL_INSTANCE_VALUE != reinterpret_cast<ULONG_PTR>(this))
+    //  풀 반환이 올바른지 검사
+    if (pNode->POOL_INSTANCE_VALUE != reinterpret_cast<ULONG_PTR>(owner))
     {
-        //    ... ߿ .
-
+        // 이 시점에서 어떻게 할지... 나중에 결정.
+        POOL_TRACE(FreeRejected, this, ptr, POOL_TRACE_REJECT_POOL);
 
-        //  ٸٸ false ȯ
+        // 만약 다르다면 false 반환
         return false;
     }
 #endif // _DEBUG
 
-    //  placement new ɼ  ִٸ,  placement new  ̹Ƿ ش ü Ҹڸ  ҷ
+    // 만약 placement new 옵션이 켜져 있다면, 생성을 placement new로 했을 것이므로 해당 객체의 소멸자를 수동으로 불러줌
     if constexpr (bPlacementNew)
     {
         pNode->data.~T();
     }
 
-    tlsNode<T>* currentNode;
+    // 객체를 만든 풀 기준으로 기록해야 Alloc 기록과 짝이 맞음
+    POOL_TRACE(Free, owner, ptr, (owner == this) ? POOL_TRACE_SOURCE_SHARED : POOL_TRACE_SOURCE_REMOTE);
+
+    // 다른 스레드의 풀이라면 주인의 free list를 건드리지 않고 remote free list에 push
+    if (owner != this)
+    {
+        owner->PushRemote(pNode, pNode);
+        return true;
+    }
+
+    // 노드 하나짜리 체인으로 push
+    PushChain(pNode, pNode, 1);
+
+    // 반환 성공
+    return true;
+}
+
+template<typename T, bool bPlacementNew>
+inline void tlsPoolHeap<T, bPlacementNew>::AllocBulk(T** out, size_t n)
+{
+    size_t filled = 0;
+
+    while (filled < n)
+    {
+        size_t remain = n - filled;
+        UINT32 want = (remain > UINT32_MAX) ? UINT32_MAX : static_cast<UINT32>(remain);
+
+        // free list에서 남은 갯수만큼 한 번에 떼어내고, 모자라면 다음 루프에서 다시 시도
+        tlsNode<T>* pNode = nullptr;
+        UINT32 count = TakeChain(pNode, want);
 
-    UINT64 stValue = InterlockedIncrement(&stamp);
-    UINT64 currentTop;
-    UINT64 newTop;
+        for (UINT32 i = 0; i < count; i++)
+        {
+            // 침투형 배치에서는 생성자가 next를 덮으므로 다음 노드를 먼저 읽어 둠
+            tlsNode<T>* nextNode = (i + 1 < count) ? AddressConverter<T>::ExtractTLSNode(pNode->next) : nullptr;
 
-    newTop = AddressConverter<T>::AddStamp(pNode, stValue);
+            if constexpr (bPlacementNew)
+            {
+                new (&(pNode->data)) T();
+            }
 
-    while (true) {
-        currentTop = top;
+            POOL_TRACE(Alloc, this, &pNode->data, POOL_TRACE_SOURCE_SHARED);
+            out[filled++] = &pNode->data;
 
-        pNode->next = currentTop; // ο  next  top 
+            pNode = nextNode;
+        }
+    }
+}
 
-        if (CAS(&top, currentTop, newTop)) {
-            break; //  Push Ϸ
+template<typename T, bool bPlacementNew>
+inline bool tlsPoolHeap<T, bPlacementNew>::FreeBulk(T** in, size_t n)
+{
+#ifdef _DEBUG
+    // 하나라도 잘못된 포인터가 섞여 있다면 아무것도 반환하지 않고 실패
+    for (size_t i = 0; i < n; i++)
+    {
+        if (in[i] == nullptr)
+            return false;
+
+        tlsNode<T>* pNode = reinterpret_cast<tlsNode<T>*>(reinterpret_cast<char*>(in[i]) - offsetof(tlsNode<T>, data));
+        if (
+            pNode->BUFFER_GUARD_FRONT != GUARD_VALUE ||
+            pNode->BUFFER_GUARD_END != GUARD_VALUE ||
+            pNode->POOL_INSTANCE_VALUE != reinterpret_cast<ULONG_PTR>(pNode->ownerPool)
+            )
+        {
+            return false;
         }
     }
+#endif // _DEBUG
+
+    // 주인 풀이 같은 연속 구간끼리 로컬에서 연결하고, 구간마다 주인 풀에 한 번의 CAS로 게시
+    size_t i = 0;
+    while (i < n)
+    {
+        tlsNode<T>* first = reinterpret_cast<tlsNode<T>*>(reinterpret_cast<char*>(in[i]) - offsetof(tlsNode<T>, data));
+        tlsPoolHeap* owner = OwnerOf(first);
+        tlsNode<T>* last = first;
+        UINT32 count = 0;
+
+        while (i < n && count < UINT32_MAX)
+        {
+            tlsNode<T>* pNode = reinterpret_cast<tlsNode<T>*>(reinterpret_cast<char*>(in[i]) - offsetof(tlsNode<T>, data));
+            if (OwnerOf(pNode) != owner)
+                break;
 
-    // Ǯ ϴ   1 
-    InterlockedIncrement(&m_curPoolCount);
+            if constexpr (bPlacementNew)
+            {
+                pNode->data.~T();
+            }
+
+            POOL_TRACE(Free, owner, in[i], (owner == this) ? POOL_TRACE_SOURCE_SHARED : POOL_TRACE_SOURCE_REMOTE);
+
+            if (count > 0)
+                last->next = reinterpret_cast<UINT64>(pNode);
+
+            last = pNode;
+            count++;
+            i++;
+        }
+
+        // 이 풀의 노드라면 free list에, 다른 스레드의 풀이라면 그 풀의 remote free list에 게시
+        if (owner == this)
+            PushChain(first, last, count);
+        else
+            owner->PushRemote(first, last);
+    }
 
-    // ȯ 
     return true;
-}
\ No newline at end of file
+}
+
+
+
+// 스레드별로 두고 쓰는 풀. 실제 상태는 tlsPoolHeap에 있고 이 객체는 그 힙을 잡고 있는 핸들
+// 생성할 때 주인 없는 힙을 입양하고, 소멸할 때(스레드 종료) 힙을 depot에 맡김
+template<typename T, bool bPlacementNew>
+class tlsMemoryPool
+{
+public:
+    // 생성자
+    // sizeInitialize : 입양한 힙에 남은 노드가 이보다 적다면 모자란 만큼 미리 할당
+    // slabNodeCount : 풀이 비었을 때 한 번에 할당할 노드 갯수, 0이면 페이지 크기에 맞춰 결정
+    // arena : 슬랩을 잘라 올 아레나, nullptr이면 malloc. 입양된 힙이 depot에 남을 수 있으므로 아레나는 프로세스 끝까지 살아야 함
+    tlsMemoryPool(UINT32 sizeInitialize = 0, UINT32 slabNodeCount = 0, SlabArena* arena = nullptr)
+    {
+        m_heap = tlsPoolHeap<T, bPlacementNew>::Adopt(slabNodeCount, arena);
+        m_heap->Reserve(sizeInitialize);
+    }
+
+    // 소멸자. 밖에 나가 있는 객체가 있어도 힙은 depot에 남으므로 늦은 Free가 안전함
+    virtual ~tlsMemoryPool(void)
+    {
+        tlsPoolHeap<T, bPlacementNew>::Orphan(m_heap);
+        m_heap = nullptr;
+    }
+
+    tlsMemoryPool(const tlsMemoryPool&) = delete;
+    tlsMemoryPool& operator=(const tlsMemoryPool&) = delete;
+
+    // 풀에 있는 객체를 넘겨주거나 새로 할당해 넘김
+    T* Alloc(void) { return m_heap->Alloc(); }
+
+    // 객체를 풀에 반환. 다른 스레드의 풀(또는 depot에 있는 힙)에서 온 객체라면 그 힙의 remote free list로 보냄
+    bool Free(T* ptr) { return m_heap->Free(ptr); }
+
+    // 객체 n개를 한 번에 할당해 out에 채움
+    void AllocBulk(T** out, size_t n) { m_heap->AllocBulk(out, n); }
+
+    // 객체 n개를 한 번에 반환
+    bool FreeBulk(T** in, size_t n) { return m_heap->FreeBulk(in, n); }
+
+public:
+    UINT32 GetCurPoolCount(void) { return m_heap->GetCurPoolCount(); }
+    UINT32 GetMaxPoolCount(void) { return m_heap->GetMaxPoolCount(); }
+    UINT32 GetSlabNodeCount(void) { return m_heap->GetSlabNodeCount(); }
+
+private:
+    tlsPoolHeap<T, bPlacementNew>* m_heap;
+};
@@ -0,0 +1,193 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include "Platform.h"
+
+#if !defined(_WIN32)
+#include <sys/syscall.h>
+#endif // _WIN32
+
+// 풀이 나눌 수 있는 최대 NUMA 노드 수
+#define NUMA_MAX_NODE_COUNT 64
+
+// 스레드가 자신의 노드를 다시 확인하기 전까지 캐시한 값을 쓰는 횟수
+#define NUMA_NODE_REFRESH_PERIOD 256
+
+// 이 환경 변수에 노드 수를 넣으면 실제 토폴로지 대신 시뮬레이션 토폴로지를 사용 (예: MEMORYPOOL_NUMA_SIMULATE=2)
+#define NUMA_SIMULATE_ENV "MEMORYPOOL_NUMA_SIMULATE"
+
+
+// NUMA 토폴로지 조회
+// 노드가 하나뿐인 장비에서도 NUMA 경로를 시험할 수 있도록 시뮬레이션 모드를 지원
+// 시뮬레이션 모드에서는 스레드를 노드에 차례로 배정하고, 메모리 바인딩은 하지 않음
+class NumaTopology
+{
+public:
+    // 노드 수. 시뮬레이션 중이라면 시뮬레이션 노드 수
+    static UINT32 GetNodeCount(void);
+
+    // 현재 스레드가 있는 노드 (0 ~ GetNodeCount() - 1)
+    static UINT32 GetCurrentNode(void);
+
+    // 시뮬레이션 노드 수를 설정. 0이면 실제 토폴로지 사용
+    // 풀을 만들기 전에 호출해야 함
+    static void SetSimulatedNodeCount(UINT32 nodeCount);
+
+    // 시뮬레이션 중인지
+    static bool IsSimulated(void) { return State().simulatedNodeCount.load(std::memory_order_relaxed) != 0; }
+
+    // 현재 스레드를 특정 노드로 고정 (시뮬레이션/테스트용). UINT32_MAX면 해제
+    static void SetThreadNode(UINT32 node) { t_pinnedNode = node; t_refreshCountdown = 0; }
+
+    // 아직 접근하지 않은 페이지가 node의 메모리에서 잡히도록 요청
+    // 시뮬레이션 중이거나 노드가 하나라면 아무것도 하지 않음. Windows는 첫 접근한 스레드의 노드에 잡히므로 따로 하지 않음
+    static void BindToNode(void* ptr, size_t bytes, UINT32 node);
+
+private:
+    struct TopologyState
+    {
+        std::atomic<UINT32> simulatedNodeCount{ 0 };
+        std::atomic<UINT32> simulatedThreadCounter{ 0 };
+        UINT32 realNodeCount = 1;
+    };
+
+    // 처음 사용할 때 실제 노드 수와 환경 변수를 읽음
+    static TopologyState& State(void)
+    {
+        static TopologyState* state = []() {
+            TopologyState* newState = new TopologyState;
+            newState->realNodeCount = QueryRealNodeCount();
+
+            const char* simulate = std::getenv(NUMA_SIMULATE_ENV);
+            if (simulate)
+            {
+                newState->simulatedNodeCount = static_cast<UINT32>(std::strtoul(simulate, nullptr, 10));
+            }
+
+            return newState;
+        }();
+
+        return *state;
+    }
+
+    static UINT32 QueryRealNodeCount(void);
+    static UINT32 QueryRealCurrentNode(void);
+
+private:
+    static inline thread_local UINT32 t_pinnedNode = UINT32_MAX;    // SetThreadNode로 고정한 노드
+    static inline thread_local UINT32 t_cachedNode = 0;
+    static inline thread_local UINT32 t_refreshCountdown = 0;
+    static inline thread_local UINT32 t_simulatedNode = UINT32_MAX; // 시뮬레이션 모드에서 배정받은 노드
+};
+
+inline UINT32 NumaTopology::GetNodeCount(void)
+{
+    TopologyState& state = State();
+    UINT32 simulated = state.simulatedNodeCount.load(std::memory_order_relaxed);
+    UINT32 count = (simulated != 0) ? simulated : state.realNodeCount;
+    return (count > NUMA_MAX_NODE_COUNT) ? NUMA_MAX_NODE_COUNT : count;
+}
+
+inline UINT32 NumaTopology::GetCurrentNode(void)
+{
+    UINT32 nodeCount = GetNodeCount();
+
+    if (t_pinnedNode != UINT32_MAX)
+        return t_pinnedNode % nodeCount;
+
+    if (IsSimulated())
+    {
+        // 스레드마다 처음 호출할 때 노드를 차례로 배정
+        if (t_simulatedNode == UINT32_MAX)
+            t_simulatedNode = State().simulatedThreadCounter.fetch_add(1, std::memory_order_relaxed);
+
+        return t_simulatedNode % nodeCount;
+    }
+
+    if (nodeCount == 1)
+        return 0;
+
+    // 노드 조회는 시스템 콜이므로 가끔만 다시 확인
+    if (t_refreshCountdown == 0)
+    {
+        t_cachedNode = QueryRealCurrentNode() % nodeCount;
+        t_refreshCountdown = NUMA_NODE_REFRESH_PERIOD;
+    }
+    t_refreshCountdown--;
+
+    return t_cachedNode;
+}
+
+inline void NumaTopology::SetSimulatedNodeCount(UINT32 nodeCount)
+{
+    State().simulatedNodeCount.store(nodeCount, std::memory_order_relaxed);
+}
+
+inline void NumaTopology::BindToNode(void* ptr, size_t bytes, UINT32 node)
+{
+    if (IsSimulated() || GetNodeCount() == 1)
+        return;
+
+#if defined(_WIN32)
+    (void)ptr;
+    (void)bytes;
+    (void)node;
+#elif defined(SYS_mbind)
+    // MPOL_PREFERRED : 가능하면 node에서, 모자라면 다른 노드에서 할당 (libnuma 없이 직접 호출)
+    const int MPOL_PREFERRED_MODE = 1;
+    unsigned long nodeMask = 1ul << node;
+    syscall(SYS_mbind, ptr, PoolPageRound(bytes), MPOL_PREFERRED_MODE, &nodeMask, sizeof(nodeMask) * 8, 0);
+#else
+    (void)ptr;
+    (void)bytes;
+    (void)node;
+#endif // _WIN32
+}
+
+inline UINT32 NumaTopology::QueryRealNodeCount(void)
+{
+#if defined(_WIN32)
+    ULONG highestNode = 0;
+    if (!GetNumaHighestNodeNumber(&highestNode))
+        return 1;
+
+    return static_cast<UINT32>(highestNode) + 1;
+#else
+    // /sys/devices/system/node/nodeN 이 있는 가장 큰 N + 1
+    UINT32 count = 1;
+    char path[64];
+    for (UINT32 node = 1; node < NUMA_MAX_NODE_COUNT; node++)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%u", node);
+        if (access(path, F_OK) == 0)
+            count = node + 1;
+    }
+
+    return count;
+#endif // _WIN32
+}
+
+inline UINT32 NumaTopology::QueryRealCurrentNode(void)
+{
+#if defined(_WIN32)
+    PROCESSOR_NUMBER processor;
+    GetCurrentProcessorNumberEx(&processor);
+
+    USHORT node = 0;
+    if (!GetNumaProcessorNodeEx(&processor, &node))
+        return 0;
+
+    return node;
+#elif defined(SYS_getcpu)
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+        return 0;
+
+    return node;
+#else
+    return 0;
+#endif // _WIN32
+}
@@ -0,0 +1,231 @@
+﻿#pragma once
+
+// 플랫폼 추상화 계층
+// Windows 전용 타입과 Interlocked 계열 함수를 std::atomic 기반으로 감싸서
+// MemoryPool / tlsMemoryPool / LockFreeStack 이 GCC, Clang 에서도 같은 lock-free 경로로 빌드되도록 함
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <chrono>
+
+#if defined(_WIN32)
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#include <Windows.h>
+#include <intrin.h>
+
+#else
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Windows.h 가 정의하는 타입 중 풀에서 사용하는 것만 맞춰서 정의
+typedef uint8_t     UINT8;
+typedef uint16_t    UINT16;
+typedef uint32_t    UINT32;
+typedef uint64_t    UINT64;
+typedef int64_t     LONG64;
+typedef uintptr_t   ULONG_PTR;
+typedef uint32_t    DWORD;
+
+#endif // _WIN32
+
+// 캐시 라인 크기. 자주 쓰이는 필드끼리 false sharing 이 나지 않도록 떨어뜨릴 때 사용
+#define CACHE_LINE_SIZE 64
+
+// 디버거가 붙어 있다면 멈추고, 아니라면 프로세스를 종료
+#if defined(_MSC_VER)
+#define POOL_DEBUG_BREAK() __debugbreak()
+#else
+#define POOL_DEBUG_BREAK() __builtin_trap()
+#endif // _MSC_VER
+
+// 스핀 대기 중에 CPU에 쉬어도 된다고 알림 (x86 pause / ARM yield)
+inline void PoolCpuRelax(void)
+{
+#if defined(_WIN32)
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif // _WIN32
+}
+
+// CPU 타임스탬프 카운터 (x86 rdtsc / ARM64 cntvct_el0). 호출 비용이 수 ns 라 이벤트마다 찍어도 됨
+// 값은 틱 단위이므로 시간으로 바꾸려면 같은 구간의 steady_clock과 비교해서 구한 초당 틱 수로 나눔
+// 카운터를 읽을 수 없는 플랫폼에서는 steady_clock의 ns 값을 반환
+inline UINT64 PoolReadTsc(void)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    UINT64 value;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return static_cast<UINT64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif // _MSC_VER
+}
+
+
+// 64비트 CAS. 성공하면 true
+// 성공시 acq_rel : 앞서 기록한 next 가 다른 스레드에서 top 을 읽었을 때 보이도록
+inline bool CAS(std::atomic<UINT64>* target, UINT64 expected, UINT64 desired)
+{
+    return target->compare_exchange_strong(expected, desired, std::memory_order_acq_rel, std::memory_order_acquire);
+}
+
+
+// OS 페이지 크기
+inline size_t PoolPageSize(void)
+{
+#if defined(_WIN32)
+    static const size_t pageSize = []() { SYSTEM_INFO info; GetSystemInfo(&info); return static_cast<size_t>(info.dwPageSize); }();
+#else
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif // _WIN32
+    return pageSize;
+}
+
+// 페이지 크기의 배수로 올림
+inline size_t PoolPageRound(size_t bytes)
+{
+    size_t pageSize = PoolPageSize();
+    return (bytes + pageSize - 1) & ~(pageSize - 1);
+}
+
+// OS에서 페이지 단위로 메모리를 직접 받아옴. 0으로 채워져 있음. 실패하면 nullptr
+// malloc과 달리 PoolPageDiscard로 물리 메모리만 골라서 돌려줄 수 있음
+inline void* PoolPageAlloc(size_t bytes)
+{
+#if defined(_WIN32)
+    return VirtualAlloc(nullptr, PoolPageRound(bytes), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    void* ptr = mmap(nullptr, PoolPageRound(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (ptr == MAP_FAILED) ? nullptr : ptr;
+#endif // _WIN32
+}
+
+// alignment(2의 거듭제곱, 페이지 크기 이상) 경계에 맞춘 메모리를 OS에서 받아옴. 0으로 채워져 있음. 실패하면 nullptr
+// 주소를 마스킹해서 블록 시작(헤더)을 찾는 용도. 해제는 PoolPageFree
+inline void* PoolPageAllocAligned(size_t bytes, size_t alignment)
+{
+    bytes = PoolPageRound(bytes);
+    if (alignment <= PoolPageSize())
+        return PoolPageAlloc(bytes);
+
+#if defined(_WIN32)
+    // 넉넉히 예약해서 정렬된 주소를 찾은 뒤, 해제하고 그 주소에 다시 예약. 그 사이 다른 스레드가 가져가면 재시도
+    for (int retry = 0; retry < 16; retry++)
+    {
+        char* probe = (char*)VirtualAlloc(nullptr, bytes + alignment, MEM_RESERVE, PAGE_NOACCESS);
+        if (probe == nullptr)
+            return nullptr;
+        char* aligned = (char*)(((uintptr_t)probe + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        VirtualFree(probe, 0, MEM_RELEASE);
+
+        void* ptr = VirtualAlloc(aligned, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (ptr != nullptr)
+            return ptr;
+    }
+    return nullptr;
+#else
+    // 넉넉히 매핑한 뒤 정렬된 구간의 앞뒤를 잘라냄
+    size_t mapBytes = bytes + alignment;
+    void* base = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        return nullptr;
+
+    char* begin = (char*)base;
+    char* aligned = (char*)(((uintptr_t)begin + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if (aligned != begin)
+        munmap(begin, aligned - begin);
+    char* end = aligned + bytes;
+    if (end != begin + mapBytes)
+        munmap(end, (begin + mapBytes) - end);
+
+    return aligned;
+#endif // _WIN32
+}
+
+// PoolPageAlloc으로 받은 메모리를 주소 공간까지 OS에 반환
+inline void PoolPageFree(void* ptr, size_t bytes)
+{
+#if defined(_WIN32)
+    (void)bytes;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, PoolPageRound(bytes));
+#endif // _WIN32
+}
+
+// 주소 공간은 유지하고 물리 메모리만 OS에 반환. OS가 거부하면 false
+// 이후에 읽어도 접근 위반은 나지 않고 0(또는 이전 값)이 보이므로, lock-free 목록에서 늦게 따라오는 스레드가 있어도 안전함
+inline bool PoolPageDiscard(void* ptr, size_t bytes)
+{
+#if defined(_WIN32)
+    return VirtualAlloc(ptr, PoolPageRound(bytes), MEM_RESET, PAGE_READWRITE) != nullptr;
+#else
+    return madvise(ptr, PoolPageRound(bytes), MADV_DONTNEED) == 0;
+#endif // _WIN32
+}
+
+
+// 128비트 CAS 용 값. 하위 64비트에 포인터, 상위 64비트에 카운터를 넣는 용도
+struct alignas(16) UINT128
+{
+    UINT64 low;
+    UINT64 high;
+};
+
+// 128비트 CAS 지원 여부
+// MSVC x64 는 cmpxchg16b 를 항상 사용할 수 있고, GCC/Clang 은 -mcx16 (또는 지원하는 아키텍처) 일 때만 사용 가능
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#define POOL_HAS_CAS128 1
+#elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define POOL_HAS_CAS128 1
+#else
+#define POOL_HAS_CAS128 0
+#endif
+
+#if POOL_HAS_CAS128
+
+// 128비트 CAS. 실패하면 expected 에 현재 값을 채워서 반환
+inline bool CAS128(volatile UINT128* target, UINT128& expected, const UINT128& desired)
+{
+#if defined(_MSC_VER)
+    return _InterlockedCompareExchange128(reinterpret_cast<volatile LONG64*>(target),
+        static_cast<LONG64>(desired.high), static_cast<LONG64>(desired.low),
+        reinterpret_cast<LONG64*>(&expected)) != 0;
+#else
+    unsigned __int128 expectedValue;
+    unsigned __int128 desiredValue;
+    memcpy(&expectedValue, &expected, sizeof(expectedValue));
+    memcpy(&desiredValue, &desired, sizeof(desiredValue));
+
+    unsigned __int128 prevValue = __sync_val_compare_and_swap(reinterpret_cast<volatile unsigned __int128*>(target), expectedValue, desiredValue);
+    if (prevValue == expectedValue)
+        return true;
+
+    memcpy(&expected, &prevValue, sizeof(expected));
+    return false;
+#endif // _MSC_VER
+}
+
+#endif // POOL_HAS_CAS128
+
+// 128비트 값을 읽음. 두 번에 나눠 읽으므로 찢어진 값이 나올 수 있지만, 이후 CAS128 에서 걸러짐
+inline UINT128 Load128(const volatile UINT128* target)
+{
+    UINT128 value;
+    value.high = target->high;
+    value.low = target->low;
+    return value;
+}
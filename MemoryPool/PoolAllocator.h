@@ -0,0 +1,139 @@
+﻿#pragma once
+
+#include <memory_resource>
+#include <type_traits>
+#include "MemoryPool.h"
+#include "SizeClassPool.h"
+
+// 풀이 정렬을 보장하는 최대값. 이보다 큰 정렬을 요구하면 정렬 지정 operator new 로 넘김
+#define POOL_ALLOCATOR_MAX_ALIGN alignof(std::max_align_t)
+
+
+// std::pmr 컨테이너용 memory_resource
+// 크기 클래스 할당기로 보내므로 어떤 크기든 받을 수 있음
+class PoolMemoryResource : public std::pmr::memory_resource
+{
+public:
+    explicit PoolMemoryResource(SizeClassPool& sizeClassPool = SizeClassPool::GetDefault())
+        : m_sizeClassPool(sizeClassPool)
+    {
+    }
+
+    // 프로세스 전체에서 공유하는 기본 인스턴스
+    static PoolMemoryResource* GetDefault(void)
+    {
+        static PoolMemoryResource* instance = new PoolMemoryResource;
+        return instance;
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        if (alignment > POOL_ALLOCATOR_MAX_ALIGN)
+        {
+            return ::operator new(bytes, std::align_val_t(alignment));
+        }
+
+        // 16바이트 이상 클래스는 모두 16의 배수 크기라 정렬이 보장됨. 작은 요청은 정렬만큼 키움
+        return m_sizeClassPool.Allocate(bytes < alignment ? alignment : bytes);
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+    {
+        if (alignment > POOL_ALLOCATOR_MAX_ALIGN)
+        {
+            ::operator delete(ptr, std::align_val_t(alignment));
+            return;
+        }
+
+        m_sizeClassPool.Deallocate(ptr, bytes < alignment ? alignment : bytes);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        const PoolMemoryResource* pOther = dynamic_cast<const PoolMemoryResource*>(&other);
+        return pOther != nullptr && &pOther->m_sizeClassPool == &m_sizeClassPool;
+    }
+
+private:
+    SizeClassPool& m_sizeClassPool;
+};
+
+
+// 상태 없는 STL 할당기
+// 1개 할당(list, map, unordered_map 의 노드)은 타입별 전역 MemoryPool 에서,
+// 여러 개 할당(vector 버퍼, 해시 버킷 배열)은 SizeClassPool 에서 가져옴 (max_align_t 보다 정렬이 큰 타입은 aligned new)
+// rebind 된 노드 타입마다 자신의 MemoryPool 을 갖게 되므로 컨테이너 코드는 그대로 둬도 됨
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = PoolAllocator<U>;
+    };
+
+public:
+    PoolAllocator(void) noexcept = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n)
+    {
+        // MemoryPool 은 노드를 타입의 정렬에 맞춰 배치하므로 over-aligned 타입도 1개 할당은 풀에서 가져옴
+        if (n == 1)
+        {
+            return reinterpret_cast<T*>(GetNodePool().Alloc());
+        }
+
+        if constexpr (alignof(T) > POOL_ALLOCATOR_MAX_ALIGN)
+        {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        }
+        else
+        {
+            return static_cast<T*>(SizeClassPool::GetDefault().Allocate(n * sizeof(T)));
+        }
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept
+    {
+        if (n == 1)
+        {
+            GetNodePool().Free(reinterpret_cast<PoolRawStorage<T>*>(ptr));
+            return;
+        }
+
+        if constexpr (alignof(T) > POOL_ALLOCATOR_MAX_ALIGN)
+        {
+            ::operator delete(ptr, std::align_val_t(alignof(T)));
+        }
+        else
+        {
+            SizeClassPool::GetDefault().Deallocate(ptr, n * sizeof(T));
+        }
+    }
+
+private:
+    // 생성은 컨테이너가 construct 로 직접 하므로 풀은 메모리만 관리 (PoolRawStorage 는 생성자가 아무것도 하지 않음)
+    // 프로세스 종료 시 정적 소멸 순서 문제를 피하기 위해 일부러 해제하지 않음
+    static MemoryPool<PoolRawStorage<T>, true>& GetNodePool(void)
+    {
+        static MemoryPool<PoolRawStorage<T>, true>* pool = new MemoryPool<PoolRawStorage<T>, true>;
+        return *pool;
+    }
+};
+
+template <typename T, typename U>
+inline bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept { return true; }
+
+template <typename T, typename U>
+inline bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept { return false; }
@@ -0,0 +1,248 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Platform.h"
+
+#if !defined(_WIN32)
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif // __linux__
+#include <functional>
+#endif // !_WIN32
+
+// 풀 동작 이벤트 기록 (ALLOC / FREE / 공유 free list Push/Pop / 슬랩 할당, 반환)
+// ABA나 이중 해제처럼 재현이 어려운 문제를 운영 중에 추적하기 위한 용도
+//
+// 켜는 방법
+//   컴파일 : MEMORYPOOL_TRACE 를 정의해야 기록 코드가 들어감. 정의하지 않으면 POOL_TRACE는 아무 코드도 만들지 않음
+//   실행 중 : PoolTrace::SetEnabled(false) 로 끄고 다시 켤 수 있음 (기본값 켜짐)
+//
+// 스레드마다 고정 크기 링(POOL_TRACE_RING_EVENTS개)에 기록하므로 스레드 간 경쟁이 없고, 오래된 이벤트부터 덮어씀
+// 링은 스레드가 끝나도 해제하지 않음. 종료한 스레드의 마지막 기록까지 덤프에 남기기 위함이며,
+// 대신 스레드를 계속 새로 만드는 프로그램에서는 스레드 수만큼 메모리가 늘어남
+//
+// PoolTrace::Dump 로 모든 링을 바이너리 파일로 쓰고, traceDecode 로 시간순 출력과 이중 해제 / 이중 할당 검사를 함
+// 덤프는 다른 스레드가 기록하는 중에도 할 수 있지만 그 순간 쓰고 있던 이벤트는 찢어져 있을 수 있음
+
+// 스레드 하나의 링에 담는 이벤트 수. 2의 거듭제곱
+#ifndef POOL_TRACE_RING_EVENTS
+#define POOL_TRACE_RING_EVENTS 4096
+#endif // POOL_TRACE_RING_EVENTS
+
+#ifdef MEMORYPOOL_TRACE
+#define POOL_TRACE(event, pool, node, aux) PoolTrace::Record(PoolTraceEvent::event, (pool), (node), (aux))
+#else
+#define POOL_TRACE(event, pool, node, aux) ((void)0)
+#endif // MEMORYPOOL_TRACE
+
+// 이벤트 종류. 덤프 파일에 그대로 기록되므로 값을 바꾸지 않고 뒤에만 추가
+enum class PoolTraceEvent : UINT16
+{
+    Alloc = 1,          // node : 반환한 객체 주소, aux : 어디서 꺼냈는지 (POOL_TRACE_SOURCE_*)
+    Free = 2,           // node : 반환받은 객체 주소, aux : 어디로 넣었는지 (POOL_TRACE_SOURCE_*)
+    FreeRejected = 3,   // node : 반환받은 객체 주소, aux : 거부한 이유 (POOL_TRACE_REJECT_*). _DEBUG 검사에서만 발생
+    PushChain = 4,      // node : 공유 free list에 게시한 첫 노드, aux : 노드 수
+    PopChain = 5,       // node : 공유 free list에서 떼어낸 첫 노드, aux : 노드 수
+    SlabAlloc = 6,      // node : 슬랩 주소, aux : 노드 수
+    SlabRelease = 7,    // node : 슬랩 주소, aux : 노드 수
+};
+
+// Alloc / Free 의 aux
+#define POOL_TRACE_SOURCE_MAGAZINE  0   // 스레드별 매거진
+#define POOL_TRACE_SOURCE_SHARED    1   // 공유 free list (tlsPoolHeap은 자기 free list)
+#define POOL_TRACE_SOURCE_NEW_SLAB  2   // 새로 할당한 슬랩
+#define POOL_TRACE_SOURCE_REMOTE    3   // 다른 스레드 풀의 remote free list (tlsPoolHeap)
+
+// FreeRejected 의 aux
+#define POOL_TRACE_REJECT_NULL      1
+#define POOL_TRACE_REJECT_GUARD     2   // 버퍼 가드가 깨짐
+#define POOL_TRACE_REJECT_POOL      3   // 다른 풀의 객체
+
+// 이벤트 하나 (32바이트)
+struct PoolTraceRecord
+{
+    UINT64 tsc;         // PoolReadTsc
+    UINT64 node;
+    UINT64 aux;
+    UINT32 pool;        // 풀 주소의 하위 32비트. 같은 덤프 안에서 풀을 구분하는 용도
+    UINT16 event;       // PoolTraceEvent
+    UINT16 reserved;
+};
+static_assert(sizeof(PoolTraceRecord) == 32, "trace record layout is part of the dump format");
+
+// 덤프 파일 형식 (기록한 머신의 바이트 순서)
+//   [PoolTraceFileHeader] ([PoolTraceRingHeader][PoolTraceRecord x recordCount]) x ringCount
+// 링의 이벤트는 오래된 것부터 기록
+#define POOL_TRACE_MAGIC "MPTRACE"
+#define POOL_TRACE_VERSION 1
+
+struct PoolTraceFileHeader
+{
+    char magic[8];          // POOL_TRACE_MAGIC
+    UINT32 version;         // POOL_TRACE_VERSION
+    UINT32 recordSize;      // sizeof(PoolTraceRecord)
+    UINT64 ticksPerSecond;  // tsc를 시간으로 바꿀 때 사용. 덤프할 때 steady_clock과 비교해서 잼
+    UINT32 ringCount;
+    UINT32 reserved;
+};
+
+struct PoolTraceRingHeader
+{
+    UINT64 threadId;        // OS 스레드 ID
+    UINT64 writeCount;      // 이 스레드가 기록한 전체 이벤트 수. recordCount보다 크다면 그만큼 덮어써서 잃음
+    UINT32 recordCount;     // 뒤따르는 이벤트 수
+    UINT32 reserved;
+};
+
+class PoolTrace
+{
+public:
+    static void SetEnabled(bool bEnable) { s_bEnabled.store(bEnable, std::memory_order_relaxed); }
+    static bool IsEnabled(void) { return s_bEnabled.load(std::memory_order_relaxed); }
+
+    // 현재 스레드의 링에 이벤트 하나를 기록. 처음 기록하는 스레드는 링을 할당받음
+    static void Record(PoolTraceEvent event, const void* pool, const void* node, UINT64 aux);
+
+    // 모든 스레드의 링을 파일로 씀. 실패하면 false
+    static bool Dump(const char* fileName);
+
+    // tsc 틱이 1초에 몇 번 증가하는지 잼. 처음 한 번만 재고 이후에는 그 값을 반환
+    static UINT64 GetTicksPerSecond(void);
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Ring
+    {
+        UINT64 threadId;
+        Ring* next;                         // 전체 링 목록. 추가만 함
+        std::atomic<UINT64> writeCount{ 0 };  // 기록한 스레드만 증가시키고, Dump가 읽음
+        PoolTraceRecord records[POOL_TRACE_RING_EVENTS];
+    };
+
+    static_assert((POOL_TRACE_RING_EVENTS & (POOL_TRACE_RING_EVENTS - 1)) == 0, "POOL_TRACE_RING_EVENTS must be a power of two");
+
+    static Ring* AttachRing(void);
+    static UINT64 CurrentThreadId(void);
+
+private:
+    static inline std::atomic<bool> s_bEnabled{ true };
+    static inline std::atomic<Ring*> s_ringList{ nullptr };
+    static inline thread_local Ring* t_ring = nullptr;
+};
+
+inline void PoolTrace::Record(PoolTraceEvent event, const void* pool, const void* node, UINT64 aux)
+{
+    if (!s_bEnabled.load(std::memory_order_relaxed))
+        return;
+
+    Ring* ring = t_ring;
+    if (ring == nullptr)
+        ring = AttachRing();
+
+    // 링의 주인만 쓰므로 원자 증가 없이 읽고 올림. release로 올려서 Dump가 내용을 먼저 보도록 함
+    UINT64 index = ring->writeCount.load(std::memory_order_relaxed);
+    PoolTraceRecord& record = ring->records[index & (POOL_TRACE_RING_EVENTS - 1)];
+    record.tsc = PoolReadTsc();
+    record.node = reinterpret_cast<UINT64>(node);
+    record.aux = aux;
+    record.pool = static_cast<UINT32>(reinterpret_cast<uintptr_t>(pool));
+    record.event = static_cast<UINT16>(event);
+    record.reserved = 0;
+    ring->writeCount.store(index + 1, std::memory_order_release);
+}
+
+inline UINT64 PoolTrace::CurrentThreadId(void)
+{
+#if defined(_WIN32)
+    return GetCurrentThreadId();
+#elif defined(__linux__)
+    return static_cast<UINT64>(syscall(SYS_gettid));
+#else
+    return std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif // _WIN32
+}
+
+inline PoolTrace::Ring* PoolTrace::AttachRing(void)
+{
+    // 덤프에서 읽을 수 있도록 일부러 해제하지 않음
+    Ring* ring = new Ring;
+    ring->threadId = CurrentThreadId();
+
+    Ring* head = s_ringList.load(std::memory_order_relaxed);
+    do {
+        ring->next = head;
+    } while (!s_ringList.compare_exchange_weak(head, ring, std::memory_order_release, std::memory_order_relaxed));
+
+    t_ring = ring;
+    return ring;
+}
+
+inline UINT64 PoolTrace::GetTicksPerSecond(void)
+{
+    static const UINT64 ticksPerSecond = []() {
+        // 20ms 동안 증가한 틱 수로 계산
+        auto beginTime = std::chrono::steady_clock::now();
+        UINT64 beginTick = PoolReadTsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        UINT64 endTick = PoolReadTsc();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+        return static_cast<UINT64>((endTick - beginTick) / seconds);
+    }();
+    return ticksPerSecond;
+}
+
+inline bool PoolTrace::Dump(const char* fileName)
+{
+    // Dump끼리 같은 파일을 동시에 쓰지 않도록 직렬화
+    static std::mutex dumpLock;
+    std::lock_guard<std::mutex> lk(dumpLock);
+
+    std::vector<Ring*> rings;
+    for (Ring* ring = s_ringList.load(std::memory_order_acquire); ring; ring = ring->next)
+        rings.push_back(ring);
+
+    FILE* file = nullptr;
+#if defined(_MSC_VER)
+    if (fopen_s(&file, fileName, "wb") != 0)
+        file = nullptr;
+#else
+    file = fopen(fileName, "wb");
+#endif // _MSC_VER
+    if (file == nullptr)
+        return false;
+
+    PoolTraceFileHeader header = {};
+    memcpy(header.magic, POOL_TRACE_MAGIC, sizeof(POOL_TRACE_MAGIC));
+    header.version = POOL_TRACE_VERSION;
+    header.recordSize = sizeof(PoolTraceRecord);
+    header.ticksPerSecond = GetTicksPerSecond();
+    header.ringCount = static_cast<UINT32>(rings.size());
+
+    bool bOk = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (Ring* ring : rings)
+    {
+        // writeCount를 먼저 읽고 그 앞의 이벤트만 씀. 링이 한 바퀴 넘게 돌았다면 가장 오래된 것부터
+        UINT64 writeCount = ring->writeCount.load(std::memory_order_acquire);
+        UINT64 recordCount = (writeCount < POOL_TRACE_RING_EVENTS) ? writeCount : POOL_TRACE_RING_EVENTS;
+        UINT64 first = writeCount - recordCount;
+
+        PoolTraceRingHeader ringHeader = {};
+        ringHeader.threadId = ring->threadId;
+        ringHeader.writeCount = writeCount;
+        ringHeader.recordCount = static_cast<UINT32>(recordCount);
+        bOk = bOk && fwrite(&ringHeader, sizeof(ringHeader), 1, file) == 1;
+
+        // 링 배열에서 이어진 두 구간으로 나눠 씀
+        UINT64 begin = first & (POOL_TRACE_RING_EVENTS - 1);
+        UINT64 headCount = (begin + recordCount <= POOL_TRACE_RING_EVENTS) ? recordCount : POOL_TRACE_RING_EVENTS - begin;
+        bOk = bOk && fwrite(&ring->records[begin], sizeof(PoolTraceRecord), headCount, file) == headCount;
+        bOk = bOk && fwrite(&ring->records[0], sizeof(PoolTraceRecord), recordCount - headCount, file) == recordCount - headCount;
+    }
+
+    bOk = (fclose(file) == 0) && bOk;
+    return bOk;
+}
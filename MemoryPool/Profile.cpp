@@ -1,15 +1,131 @@
 
 #include "Profile.h"
 #include <mutex>
+#include <filesystem>
+#include <thread>
+#include <unordered_map>
 
 #define PRECISION 8
 
 thread_local std::vector<ProfileData> profileDatas;
 static std::vector<ProfileData> g_allProfileDatas;
 
-// ̳  ȣ ؽ
+// 컨테이너 접근을 보호할 뮤텍스
 static std::mutex               g_profilesMutex;
 
+// 태그 ID 기반 프로파일러의 스레드별 누적값. 0으로 초기화된 고정 배열이므로 힙을 쓰지 않음
+thread_local ProfileSlot t_profileSlots[PROFILE_MAX_TAGS];
+
+// 등록한 태그 목록. ID는 names의 인덱스이며 해시가 같으면 이름까지 비교해서 찾음
+struct ProfileTagRegistry
+{
+    std::mutex lock;
+    std::vector<std::wstring> names{ L"(tag overflow)" };
+    std::unordered_multimap<UINT64, ProfileTagId> ids;
+};
+
+// 종료 시점의 Flush와 순서가 꼬이지 않도록 일부러 해제하지 않음
+static ProfileTagRegistry& GetTagRegistry()
+{
+    static ProfileTagRegistry* registry = new ProfileTagRegistry;
+    return *registry;
+}
+
+ProfileTagId ProfileRegisterTag(UINT64 hash, std::wstring_view name)
+{
+    ProfileTagRegistry& registry = GetTagRegistry();
+    std::lock_guard<std::mutex> lk(registry.lock);
+
+    auto range = registry.ids.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (registry.names[it->second] == name)
+            return it->second;
+    }
+
+    // 다 찼다면 0번 태그로 모음
+    if (registry.names.size() >= PROFILE_MAX_TAGS)
+        return 0;
+
+    ProfileTagId id = static_cast<ProfileTagId>(registry.names.size());
+    registry.names.emplace_back(name);
+    registry.ids.emplace(hash, id);
+    return id;
+}
+
+ProfileTagId ProfileRegisterTag(const std::wstring& name)
+{
+    return ProfileRegisterTag(ProfileHash(name), name);
+}
+
+std::wstring ProfileTagName(ProfileTagId id)
+{
+    ProfileTagRegistry& registry = GetTagRegistry();
+    std::lock_guard<std::mutex> lk(registry.lock);
+    return (id < registry.names.size()) ? registry.names[id] : std::wstring();
+}
+
+void ProfileInsertMinTicks(ProfileSlot& slot, UINT32 filled, UINT64 elapsed)
+{
+    // 목록이 찼다면 가장 큰 값을 밀어냄
+    UINT32 i = (filled < THRESHOLD) ? filled : THRESHOLD - 1;
+    for (; i > 0 && slot.minTicks[i - 1] > elapsed; --i)
+        slot.minTicks[i] = slot.minTicks[i - 1];
+    slot.minTicks[i] = elapsed;
+}
+
+void ProfileInsertMaxTicks(ProfileSlot& slot, UINT32 filled, UINT64 elapsed)
+{
+    UINT32 i = (filled < THRESHOLD) ? filled : THRESHOLD - 1;
+    for (; i > 0 && slot.maxTicks[i - 1] < elapsed; --i)
+        slot.maxTicks[i] = slot.maxTicks[i - 1];
+    slot.maxTicks[i] = elapsed;
+}
+
+// 출력할 값에서 Begin/End 한 쌍의 측정 비용을 뺌. 측정 오차로 음수가 되면 0으로
+static double ProfileCorrectTicks(double ticks, double calls = 1.0)
+{
+    double corrected = ticks - ProfileClock::OverheadTicks() * calls;
+    return (corrected > 0.0) ? corrected : 0.0;
+}
+
+// 사이클 열. OS 시계를 쓰는 중이라면 사이클을 알 수 없으므로 비워 둠
+static void WriteProfileCycles(std::wofstream& file, int width, double ticks)
+{
+    if (ProfileClock::IsTsc())
+        file << std::setw(width) << std::fixed << std::setprecision(1) << ticks;
+    else
+        file << std::setw(width) << L"-";
+}
+
+// 보고서 첫 줄. 어떤 시계로 쟀는지와 측정 비용을 얼마나 뺐는지 남김
+static void WriteProfileClockInfo(std::wofstream& file)
+{
+    double overhead = ProfileClock::OverheadTicks();
+    if (ProfileClock::IsTsc())
+        file << L"# clock: invariant TSC " << std::fixed << std::setprecision(1) << ProfileClock::TicksPerSecond() / 1e6 << L" MHz";
+    else
+        file << L"# clock: monotonic (ns)";
+    file << L", overhead " << std::fixed << std::setprecision(1) << overhead << L" ticks ("
+        << ProfileClock::TicksToNs(overhead) << L" ns) subtracted per call\n";
+}
+
+// 같은 이름의 전역 데이터를 찾고, 없다면 추가. g_profilesMutex를 잡은 상태에서 호출
+static ProfileData& FindOrAddGlobalProfileData(const std::wstring& name)
+{
+    auto it = std::find_if(
+        g_allProfileDatas.begin(), g_allProfileDatas.end(),
+        [&](const ProfileData& pd) {
+            return pd.name == name;
+        });
+
+    if (it != g_allProfileDatas.end())
+        return *it;
+
+    g_allProfileDatas.push_back(ProfileData(name));
+    return g_allProfileDatas.back();
+}
+
 ProfileData* findProfileData(const std::wstring& name) {
     for (auto& sample : profileDatas) {
         if (sample.name == name) {
@@ -19,18 +135,18 @@ ProfileData* findProfileData(const std::wstring& name) {
     return nullptr;
 }
 
-// ϸ 
+// 프로파일링 시작
 void ProfileBegin(const std::wstring& name) {
-    //  
+    // 데이터 추출
     ProfileData* data = findProfileData(name);
 
-    // ٸ ߰
+    // 없다면 추가
     if (!data) {
         profileDatas.push_back(ProfileData(name));
         data = &profileDatas.back();
     }
 
-    // Ÿ̸ 
+    // 타이머 시작
     data->timer.start();
 }
 
@@ -58,25 +174,28 @@ void UpdateMaxTime(ProfileData* data, double elapsedTime) {
     }
 }
 
-// ϸ 
+// 프로파일링 끝
 void ProfileEnd(const std::wstring& name) {
-    // ͸ ã
+    // 이름을 찾는 시간이 측정에 섞이지 않도록 끝 시각부터 읽음
+    UINT64 endTick = ProfileClock::End();
+
+    // 데이터를 찾음
     ProfileData* data = findProfileData(name);
 
-    // Ͱ Ѵٸ
-    //    Ϳ ߰
+    // 데이터가 존재한다면
+    // 측정후 나온 값을 데이터에 추가
     if (data) {
-        //  ð 
-        double elapsedTime = data->timer.stop();
+        // 지난 시간 (틱)
+        double elapsedTime = static_cast<double>(data->timer.elapsed(endTick));
 
-        // ü ð ϱ
+        // 전체 시간에 더하기
         data->totalTime += elapsedTime;
 
-        // ְ ð   ð 
+        // 최고 시간 및 최저 시간 갱신
         UpdateMinTime(data, elapsedTime);
         UpdateMaxTime(data, elapsedTime);
 
-        // Լ ȣ Ƚ 
+        // 함수 호출 횟수 연산
         data->callCount++;
     }
 }
@@ -90,13 +209,13 @@ void ProfileEnd(const std::wstring& name) {
 //
 //    for (const auto& data : profileDatas) {
 //
-//        // ȣ Ƚ  ֺܹ  ٸ ǥ  ͸    ϱ
+//        // 호출한 횟수가 설정한 예외범주보다 더 많다면 표준편차에서 벗어난 데이터를 제거 후 평균 구하기
 //        if (data.callCount > THRESHOLD * 2)
 //        {
 //            int originalCallCnt = data.callCount;
 //            double originalTotalTime = data.totalTime;
 //
-//            // totalTime ϰ ƯⳭ  
+//            // totalTime에서 과하게 특출난 데이터 제거
 //            for (UINT8 i = 0; i < THRESHOLD; ++i)
 //            {
 //                originalTotalTime -= data.minTime[i];
@@ -107,7 +226,7 @@ void ProfileEnd(const std::wstring& name) {
 //
 //            averageTime = originalTotalTime / originalCallCnt;
 //        }
-//        // ƴ϶ ٷ  ϱ
+//        // 아니라면 바로 평균 구하기
 //        else
 //        {
 //            averageTime = data.totalTime / data.callCount;
@@ -125,20 +244,21 @@ void ProfileEnd(const std::wstring& name) {
 
 void ProfileDataOutText(const std::wstring& fileName)
 {
-    std::wofstream file(fileName);
-    file << L"Name\t|\tAverage\t|\tMin\t|\tMax\t|\tCalls\n";
-    file << L"-----------------------------------------------------------\n";
+    std::wofstream file{ std::filesystem::path(fileName) };
+    WriteProfileClockInfo(file);
+    file << L"Name\t|\tAverage(ns)\t|\tMin(ns)\t|\tMax(ns)\t|\tCalls\t|\tAverage(cycles)\n";
+    file << L"-----------------------------------------------------------------------------------\n";
 
     for (const auto& data : g_allProfileDatas)
     {
         double averageTime;
 
-        // ̻ġ   
+        // 이상치 제거 후 평균
         if (data.callCount > THRESHOLD * 2)
         {
             int cnt = data.callCount;
             double tot = data.totalTime;
-            // / THRESHOLD  
+            // 상위/하위 THRESHOLD 개씩 빼기
             for (int i = 0; i < THRESHOLD; ++i)
             {
                 tot -= data.minTime[i];
@@ -151,13 +271,16 @@ void ProfileDataOutText(const std::wstring& fileName)
         {
             averageTime = data.totalTime / data.callCount;
         }
+        averageTime = ProfileCorrectTicks(averageTime);
 
         file << std::left << data.name
-            << L"\t" << std::fixed << std::setprecision(PRECISION) << averageTime
-            << L"\t" << data.minTime[0]
-            << L"\t" << data.maxTime[0]
+            << L"\t" << std::fixed << std::setprecision(PRECISION) << ProfileClock::TicksToNs(averageTime)
+            << L"\t" << ProfileClock::TicksToNs(ProfileCorrectTicks(data.minTime[0]))
+            << L"\t" << ProfileClock::TicksToNs(ProfileCorrectTicks(data.maxTime[0]))
             << L"\t" << data.callCount
-            << L"\n";
+            << L"\t";
+        WriteProfileCycles(file, 0, averageTime);
+        file << L"\n";
     }
 
     file.close();
@@ -166,16 +289,17 @@ void ProfileDataOutText(const std::wstring& fileName)
 
 void ProfileReset() {
     profileDatas.clear();
+    memset(t_profileSlots, 0, sizeof(t_profileSlots));
 }
 
-// TLS   ű, name  ջ
+// TLS → 전역으로 옮기고, name 기준으로 합산
 void FlushThreadProfileData()
 {
     std::lock_guard<std::mutex> lk(g_profilesMutex);
 
     for (auto& td : profileDatas)
     {
-        //  name ׸ ã
+        // 같은 name 항목 찾기
         auto it = std::find_if(
             g_allProfileDatas.begin(), g_allProfileDatas.end(),
             [&](const ProfileData& pd) {
@@ -184,16 +308,16 @@ void FlushThreadProfileData()
 
         if (it == g_allProfileDatas.end())
         {
-            // ű ±׸ ״ move
+            // 신규 태그면 그대로 move
             g_allProfileDatas.push_back(std::move(td));
         }
         else
         {
-            //  ±׸ ð ջ, ȣ Ƚ ջ
+            // 기존 태그면 시간 합산, 호출 횟수 합산
             it->totalTime += td.totalTime;
             it->callCount += td.callCount;
 
-            // () ʿϴٸ min/max 赵   
+            // (선택) 필요하다면 min/max 통계도 갱신할 수 있음
             for (int i = 0; i < THRESHOLD; ++i) {
                 it->minTime[i] = std::min(it->minTime[i], td.minTime[i]);
                 it->maxTime[i] = std::max(it->maxTime[i], td.maxTime[i]);
@@ -201,65 +325,94 @@ void FlushThreadProfileData()
         }
     }
 
-    // TLS  
+    // TLS 벡터 비우기
     profileDatas.clear();
+
+    // 태그 ID 기반 누적값을 같은 이름의 전역 데이터에 합산. 둘 다 틱 단위이므로 변환 없이 더함
+    for (ProfileTagId id = 0; id < PROFILE_MAX_TAGS; ++id)
+    {
+        ProfileSlot& slot = t_profileSlots[id];
+        if (slot.callCount == 0)
+            continue;
+
+        ProfileData& pd = FindOrAddGlobalProfileData(ProfileTagName(id));
+        pd.totalTime += static_cast<double>(slot.totalTicks);
+        pd.callCount += static_cast<int>(slot.callCount);
+
+        UINT32 filled = (slot.callCount < THRESHOLD) ? static_cast<UINT32>(slot.callCount) : THRESHOLD;
+        for (UINT32 i = 0; i < filled; ++i)
+        {
+            UpdateMinTime(&pd, static_cast<double>(slot.minTicks[i]));
+            UpdateMaxTime(&pd, static_cast<double>(slot.maxTicks[i]));
+        }
+
+        memset(&slot, 0, sizeof(slot));
+    }
 }
 
 void ProfileDataOutTextMultiThread(const std::wstring& fileName)
 {
-    std::wofstream file(fileName);
+    std::wofstream file{ std::filesystem::path(fileName) };
     if (!file.is_open()) return;
 
-    // 
+    // 헤더
+    WriteProfileClockInfo(file);
     file
         << std::left << std::setw(24) << L"Name"
-        << L" | " << std::right << std::setw(12) << L"Average"
+        << L" | " << std::right << std::setw(12) << L"Average(ns)"
+        << L" | " << std::setw(12) << L"Cycles"
         << L" | " << std::setw(8) << L"Calls"
-        << L" | " << std::setw(12) << L"Total"
-        << L" | " << std::setw(12) << L"Min"
-        << L" | " << std::setw(12) << L"Max"
+        << L" | " << std::setw(12) << L"Total(ms)"
+        << L" | " << std::setw(12) << L"Min(ns)"
+        << L" | " << std::setw(12) << L"Max(ns)"
         << L"\n";
 
-    // м
-    file << std::wstring(24 + 3 + 12 + 3 + 8 + 3 + 12 + 3 + 12 + 3 + 12, L'-') << L"\n";
+    // 구분선
+    file << std::wstring(24 + 3 + 12 + 3 + 12 + 3 + 8 + 3 + 12 + 3 + 12 + 3 + 12, L'-') << L"\n";
 
-    //  
+    // 데이터 행. 값은 모두 틱 단위이므로 측정 비용을 뺀 뒤 여기서 ns / ms로 바꿈
     for (const auto& pd : g_allProfileDatas)
     {
         double average = pd.callCount > 0
-            ? pd.totalTime / pd.callCount
+            ? ProfileCorrectTicks(pd.totalTime / pd.callCount)
             : 0.0;
+        double total = ProfileCorrectTicks(pd.totalTime, pd.callCount);
 
-        // ü ȣ  ּҡִ ð 
+        // 전체 호출 중 최소·최대 시간 계산
         double minVal = DBL_MAX;
         double maxVal = DBL_MIN;
         for (int i = 0; i < THRESHOLD; ++i) {
             minVal = std::min(minVal, pd.minTime[i]);
             maxVal = std::max(maxVal, pd.maxTime[i]);
         }
-        //   ȣ ٸ 0
+        // 만약 실제 호출이 없었다면 0으로
         if (pd.callCount == 0) {
             minVal = maxVal = 0.0;
         }
+        minVal = ProfileCorrectTicks(minVal);
+        maxVal = ProfileCorrectTicks(maxVal);
 
         file
-            // Name ( , 24ĭ)
+            // Name (좌측 정렬, 24칸)
             << std::left << std::setw(24) << pd.name
             << L" | "
-            // Average ( , Ҽ 6ڸ, 12ĭ)
-            << std::right << std::setw(12) << std::fixed << std::setprecision(6) << average
+            // Average (우측 정렬, ns 소수점 1자리, 12칸)
+            << std::right << std::setw(12) << std::fixed << std::setprecision(1) << ProfileClock::TicksToNs(average)
+            << L" | ";
+        // Cycles (평균 사이클, 12칸)
+        WriteProfileCycles(file, 12, average);
+        file
             << L" | "
-            // Calls ( , 8ĭ)
+            // Calls (우측 정렬, 8칸)
             << std::setw(8) << pd.callCount
             << L" | "
-            // Total ( , Ҽ 6ڸ, 12ĭ)
-            << std::setw(12) << std::fixed << std::setprecision(6) << pd.totalTime
+            // Total (우측 정렬, ms 소수점 3자리, 12칸)
+            << std::setw(12) << std::fixed << std::setprecision(3) << ProfileClock::TicksToNs(total) / 1e6
             << L" | "
-            // Min ( , Ҽ 6ڸ, 12ĭ)
-            << std::setw(12) << std::fixed << std::setprecision(6) << minVal
+            // Min / Max (우측 정렬, ns 소수점 1자리, 12칸)
+            << std::setw(12) << std::fixed << std::setprecision(1) << ProfileClock::TicksToNs(minVal)
             << L" | "
-            // Max ( , Ҽ 6ڸ, 12ĭ)
-            << std::setw(12) << std::fixed << std::setprecision(6) << maxVal
+            << std::setw(12) << std::fixed << std::setprecision(1) << ProfileClock::TicksToNs(maxVal)
             << L"\n";
     }
 
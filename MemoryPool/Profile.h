@@ -1,51 +1,204 @@
 
 #pragma once
 
-#define NOMINMAX
 #include <iostream>
-#include <Windows.h>
+#include <chrono>
+#include "Platform.h"
 
 #include <vector>
 #include <string>
+#include <thread>
+#include <string_view>
+#include <type_traits>
 
 #include <fstream>
 #include <iomanip>      // setw, setprecision
 #include <cfloat>       // DBL_MAX, DBL_MIN
 #include <algorithm>    // std::min, std::max
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define PROFILE_X86_TSC 1
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#define PROFILE_X86_TSC 1
+#include <x86intrin.h>
+#include <cpuid.h>
+#else
+#define PROFILE_X86_TSC 0
+#endif
+
+#if !defined(_WIN32)
+#include <time.h>
+#endif // !_WIN32
+
+// 프로파일러 시간 원본
+// 불변(invariant) TSC가 있다면 CPU 타임스탬프 카운터를, 없다면 OS 단조 시계(clock_gettime / steady_clock)의 ns 값을 틱으로 씀
+// 구간마다 틱 차이만 더해 두고, 시간으로 바꾸는 나눗셈과 측정 비용 빼기는 출력할 때 한 번만 함
+//   초당 틱 수 : 프로그램 시작 시점과 처음 출력하는 시점의 (틱, steady_clock) 쌍으로 계산 (최소 50ms 간격)
+//   측정 비용 : 빈 Begin/End 쌍을 반복해서 잰 중앙값. 출력할 때 구간마다 이만큼 빼서 보여줌
+class ProfileClock
+{
+public:
+    // 구간 시작. 앞선 명령이 끝난 뒤에 읽고(lfence), 구간 안의 명령이 읽기보다 먼저 실행되지 않도록 막음
+    static UINT64 Begin(void)
+    {
+#if PROFILE_X86_TSC
+        if (s_bInvariantTsc)
+        {
+            _mm_lfence();
+            UINT64 tick = __rdtsc();
+            _mm_lfence();
+            return tick;
+        }
+#endif // PROFILE_X86_TSC
+        return MonotonicNs();
+    }
+
+    // 구간 끝. rdtscp는 앞선 명령이 모두 끝난 뒤에 읽고, 뒤따르는 명령이 읽기보다 먼저 실행되지 않도록 lfence
+    static UINT64 End(void)
+    {
+#if PROFILE_X86_TSC
+        if (s_bInvariantTsc)
+        {
+            unsigned int aux;
+            UINT64 tick = __rdtscp(&aux);
+            _mm_lfence();
+            return tick;
+        }
+#endif // PROFILE_X86_TSC
+        return MonotonicNs();
+    }
+
+    // 틱이 TSC(기준 클럭 사이클)인지, OS 시계의 ns인지
+    static bool IsTsc(void) { return s_bInvariantTsc; }
+
+    // 초당 틱 수. 처음 호출할 때 계산
+    static double TicksPerSecond(void);
+
+    // Begin/End 한 쌍의 비용 (틱). 처음 호출할 때 측정
+    static double OverheadTicks(void);
+
+    static double TicksToNs(double ticks) { return ticks * 1e9 / TicksPerSecond(); }
+
+private:
+    static UINT64 MonotonicNs(void)
+    {
+#if defined(_WIN32)
+        return static_cast<UINT64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<UINT64>(ts.tv_sec) * 1000000000ull + static_cast<UINT64>(ts.tv_nsec);
+#endif // _WIN32
+    }
+
+    // CPUID 0x80000007 EDX 8번 비트. 꺼져 있다면 코어/절전 상태에 따라 TSC 속도가 달라질 수 있으므로 쓰지 않음
+    static bool DetectInvariantTsc(void)
+    {
+#if PROFILE_X86_TSC
+#if defined(_MSC_VER)
+        int regs[4];
+        __cpuid(regs, 0x80000000);
+        if (static_cast<unsigned int>(regs[0]) < 0x80000007)
+            return false;
+        __cpuid(regs, 0x80000007);
+        return (regs[3] & (1 << 8)) != 0;
+#else
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+            return false;
+        return (edx & (1u << 8)) != 0;
+#endif // _MSC_VER
+#else
+        return false;
+#endif // PROFILE_X86_TSC
+    }
+
+    struct CalibrationPoint
+    {
+        UINT64 tick;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    static CalibrationPoint Now(void) { return CalibrationPoint{ Begin(), std::chrono::steady_clock::now() }; }
+
+private:
+    static inline const bool s_bInvariantTsc = DetectInvariantTsc();
+    static inline const CalibrationPoint s_startPoint = Now();
+};
+
+inline double ProfileClock::TicksPerSecond(void)
+{
+    static const double ticksPerSecond = []() {
+        // OS 시계를 쓰는 중이라면 틱이 곧 ns
+        if (!s_bInvariantTsc)
+            return 1e9;
+
+        // 간격이 짧으면 steady_clock 해상도 오차가 커지므로 최소 50ms를 확보
+        auto minimum = s_startPoint.time + std::chrono::milliseconds(50);
+        if (std::chrono::steady_clock::now() < minimum)
+            std::this_thread::sleep_until(minimum);
+
+        CalibrationPoint endPoint = Now();
+        double seconds = std::chrono::duration<double>(endPoint.time - s_startPoint.time).count();
+        return static_cast<double>(endPoint.tick - s_startPoint.tick) / seconds;
+    }();
+    return ticksPerSecond;
+}
+
+inline double ProfileClock::OverheadTicks(void)
+{
+    static const double overheadTicks = []() {
+        const int sampleCount = 1001;
+        std::vector<UINT64> samples(sampleCount);
+        for (int i = 0; i < sampleCount; ++i)
+        {
+            UINT64 begin = Begin();
+            samples[i] = End() - begin;
+        }
+        std::nth_element(samples.begin(), samples.begin() + sampleCount / 2, samples.end());
+        return static_cast<double>(samples[sampleCount / 2]);
+    }();
+    return overheadTicks;
+}
+
+// 구간 하나를 재는 타이머. 경과 시간은 틱 단위로 반환하고, 시간으로 바꾸는 것은 출력할 때 ProfileClock으로
 class CProfileTimer
 {
 public:
     CProfileTimer() {
-        QueryPerformanceFrequency(&freq);
         start();
     }
 
     void start() {
-        QueryPerformanceCounter(&startTime);
+        startTick = ProfileClock::Begin();
+    }
+
+    // 지금까지의 경과 틱
+    UINT64 stop() {
+        return elapsed(ProfileClock::End());
     }
 
-    double stop() {
-        LARGE_INTEGER endTime;
-        QueryPerformanceCounter(&endTime);
-        return 1.f * (endTime.QuadPart - startTime.QuadPart) / freq.QuadPart; // microseconds
+    // 미리 읽어 둔 끝 시각까지의 경과 틱
+    UINT64 elapsed(UINT64 endTick) const {
+        return endTick - startTick;
     }
 
 private:
-    LARGE_INTEGER freq;
-    LARGE_INTEGER startTime;
+    UINT64 startTick;
 };
 
-// ϸ ü
+// 프로파일링용 구조체
 #define THRESHOLD 20
 
+// 시간 값은 모두 ProfileClock 틱 단위. ns / 사이클로 바꾸고 측정 비용을 빼는 것은 출력할 때 함
 typedef struct _tagProfileData {
     std::wstring name;
     double totalTime = 0;
     double minTime[THRESHOLD];
     double maxTime[THRESHOLD];
     int callCount = 0;
-    CProfileTimer timer; // Ÿ̸
+    CProfileTimer timer; // 타이머
 
     _tagProfileData(const std::wstring& _name)
     {
@@ -92,6 +245,100 @@ private:
     std::wstring m_tagName;
 };
 
+
+// 태그 ID 기반 프로파일러
+// 위의 이름 기반 API는 구간마다 wstring을 복사하고 스레드 목록을 이름으로 선형 탐색하므로, 수십 ns짜리 구간을 재면 측정 비용이 더 큼
+// 태그를 한 번 등록해서 받은 ID로 스레드별 고정 배열을 바로 인덱싱하므로 Begin/End는 틱 읽기와 덧셈 몇 번이며 힙을 쓰지 않음
+//   static 문자열 : ProfileScope pf(PRO_TAG(L"pool alloc"));           해시는 컴파일 타임, 등록은 처음 한 번
+//   실행 중 만든 이름 : ProfileTagId tag = ProfileRegisterTag(name);   루프 밖에서 등록해 두고 ProfileScope pf(tag);
+// 같은 이름은 같은 ID로 모임 (intern). 결과는 FlushThreadProfileData 때 이름 기반 데이터와 합쳐져서 같은 파일로 출력됨
+
+// 등록할 수 있는 태그 수. 0번은 넘쳤을 때 모아 두는 태그
+#define PROFILE_MAX_TAGS 128
+
+typedef UINT32 ProfileTagId;
+
+// FNV-1a 64비트. constexpr이므로 문자열 리터럴이라면 컴파일 타임에 계산됨
+constexpr UINT64 ProfileHash(std::wstring_view name)
+{
+    UINT64 hash = 14695981039346656037ull;
+    for (wchar_t c : name)
+    {
+        hash ^= static_cast<UINT64>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// 태그를 등록하고 ID를 반환. 이미 등록된 이름이라면 같은 ID. 락을 잡으므로 측정 구간 밖에서 호출
+ProfileTagId ProfileRegisterTag(const std::wstring& name);
+ProfileTagId ProfileRegisterTag(UINT64 hash, std::wstring_view name);
+
+// 등록한 태그의 이름
+std::wstring ProfileTagName(ProfileTagId id);
+
+// 태그 하나의 스레드별 누적값 (ProfileClock 틱 단위)
+// 최소/최대는 이름 기반과 같이 THRESHOLD개씩 보관하며, 호출 횟수가 THRESHOLD보다 적다면 앞의 callCount개만 유효
+struct ProfileSlot
+{
+    UINT64 startTick;
+    UINT64 totalTicks;
+    UINT64 callCount;
+    UINT64 minTicks[THRESHOLD];     // 오름차순
+    UINT64 maxTicks[THRESHOLD];     // 내림차순
+};
+
+extern thread_local ProfileSlot t_profileSlots[PROFILE_MAX_TAGS];
+
+// 상위/하위 THRESHOLD개 목록에 끼워 넣음. 목록이 찬 뒤에는 기록을 갱신할 때만 호출되므로 드문 경로
+void ProfileInsertMinTicks(ProfileSlot& slot, UINT32 filled, UINT64 elapsed);
+void ProfileInsertMaxTicks(ProfileSlot& slot, UINT32 filled, UINT64 elapsed);
+
+inline void ProfileBeginId(ProfileTagId id)
+{
+    t_profileSlots[id].startTick = ProfileClock::Begin();
+}
+
+inline void ProfileEndId(ProfileTagId id)
+{
+    UINT64 endTick = ProfileClock::End();
+    ProfileSlot& slot = t_profileSlots[id];
+    UINT64 elapsed = endTick - slot.startTick;
+
+    UINT32 filled = (slot.callCount < THRESHOLD) ? static_cast<UINT32>(slot.callCount) : THRESHOLD;
+    slot.totalTicks += elapsed;
+    slot.callCount++;
+
+    if (filled < THRESHOLD || elapsed < slot.minTicks[THRESHOLD - 1])
+        ProfileInsertMinTicks(slot, filled, elapsed);
+    if (filled < THRESHOLD || elapsed > slot.maxTicks[THRESHOLD - 1])
+        ProfileInsertMaxTicks(slot, filled, elapsed);
+}
+
+// 문자열 리터럴 태그. 해시는 컴파일 타임에 구하고, 호출 위치마다 처음 한 번만 등록
+#define PRO_TAG(literal) ([]() { static const ProfileTagId id = ProfileRegisterTag(std::integral_constant<UINT64, ProfileHash(literal)>::value, literal); return id; }())
+
+#ifdef PROFILE
+#define PRO_BEGIN_ID(tagId) ProfileBeginId(tagId)
+#define PRO_END_ID(tagId) ProfileEndId(tagId)
+#else
+#define PRO_BEGIN_ID(tagId)
+#define PRO_END_ID(tagId)
+#endif
+
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileTagId tagId) : m_tagId(tagId) {
+        PRO_BEGIN_ID(m_tagId);
+    }
+    ~ProfileScope() {
+        PRO_END_ID(m_tagId);
+    }
+
+private:
+    ProfileTagId m_tagId;
+};
+
 //void Func()
 //{
 //    {
@@ -0,0 +1,216 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "Platform.h"
+#include "SlabArena.h"
+
+// 생산자 스레드 하나, 소비자 스레드 하나 사이의 고정 크기 lock-free 큐
+// 각 위치는 자기 쪽만 쓰므로 CAS가 없고, 한쪽이 상대 위치를 acquire로 읽고 자기 위치를 release로 올리는 것으로 충분함
+// 상대 위치는 지역 사본(cached)으로 들고 있다가 사본만으로 공간/원소가 모자랄 때만 다시 읽으므로
+// 평상시에는 상대 캐시 라인을 건드리지 않음
+// 여러 개를 한꺼번에 넣거나 꺼내면 위치를 한 번만 갱신하므로 원소당 release store도 줄어듦
+// 생산자/소비자가 여러 스레드라면 MPMCQueue를 사용
+template <typename T>
+class SPSCQueue {
+public:
+    // capacity : 최대 원소 수. 2의 거듭제곱으로 올림 (최소 2)
+    // arena : 원소 배열을 잘라 올 아레나. nullptr이면 힙. 아레나는 큐보다 오래 살아야 함
+    explicit SPSCQueue(size_t capacity, SlabArena* arena = nullptr);
+    ~SPSCQueue();
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    // 생산자 쪽. 가득 찼다면 false
+    bool try_enqueue(const T& data) { return try_emplace(data); }
+    bool try_enqueue(T&& data) { return try_emplace(std::move(data)); }
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args);
+
+    // 생산자 쪽. first부터 최대 count개를 넣고 위치는 한 번만 올림. 넣은 개수를 반환
+    // std::make_move_iterator로 감싸서 넘기면 원소를 옮겨 담음
+    template <typename InputIt>
+    size_t try_enqueue_bulk(InputIt first, size_t count);
+
+    // 소비자 쪽. 비어 있다면 false
+    bool try_dequeue(T& data);
+
+    // 소비자 쪽. 최대 maxCount개를 out으로 옮기고 위치는 한 번만 올림. 꺼낸 개수를 반환
+    template <typename OutputIt>
+    size_t try_dequeue_bulk(OutputIt out, size_t maxCount);
+
+    size_t capacity(void) const { return m_mask + 1; }
+
+    // 상대 스레드가 동시에 넣고 꺼내는 중이라면 근삿값
+    size_t size_approx(void) const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+
+private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* Data(void) { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    static constexpr size_t SLOT_ALIGN = (alignof(Slot) > CACHE_LINE_SIZE) ? alignof(Slot) : CACHE_LINE_SIZE;
+
+    static size_t RoundUpPowerOfTwo(size_t value);
+
+    // 생산자 쪽. 사본만으로 count개 공간이 없다면 소비자 위치를 다시 읽음. 비어 있는 칸 수를 반환
+    size_t FreeSlots(size_t tail, size_t count);
+
+    // 소비자 쪽. 사본만으로 count개 원소가 없다면 생산자 위치를 다시 읽음. 채워진 칸 수를 반환
+    size_t FilledSlots(size_t head, size_t count);
+
+private:
+    // 생성 후 바뀌지 않아 양쪽이 읽기만 하는 값
+    Slot* m_slots;
+    size_t m_mask;          // capacity - 1
+    SlabArena* m_arena;     // 원소 배열을 잘라 온 아레나, nullptr이면 힙
+
+    // 생산자만 쓰는 캐시 라인 : 다음에 넣을 위치와 소비자 위치 사본
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail;
+    size_t m_cachedHead;
+
+    // 소비자만 쓰는 캐시 라인 : 다음에 꺼낼 위치와 생산자 위치 사본
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head;
+    size_t m_cachedTail;
+    char m_padding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+};
+
+template <typename T>
+inline size_t SPSCQueue<T>::RoundUpPowerOfTwo(size_t value)
+{
+    size_t result = 2;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+template <typename T>
+inline SPSCQueue<T>::SPSCQueue(size_t capacity, SlabArena* arena)
+    : m_mask(RoundUpPowerOfTwo(capacity) - 1), m_arena(arena), m_tail(0), m_cachedHead(0), m_head(0), m_cachedTail(0)
+{
+    size_t bytes = sizeof(Slot) * (m_mask + 1);
+
+    void* memory = nullptr;
+    if (m_arena)
+        memory = m_arena->Allocate(bytes, SLOT_ALIGN);
+    if (memory == nullptr)
+    {
+        // 아레나가 모자라다면 힙에서 받음. 소멸자가 구분할 수 있도록 아레나를 지움
+        m_arena = nullptr;
+        memory = ::operator new(bytes, std::align_val_t(SLOT_ALIGN));
+    }
+
+    m_slots = static_cast<Slot*>(memory);
+}
+
+template <typename T>
+inline SPSCQueue<T>::~SPSCQueue()
+{
+    // 남아 있는 원소의 소멸자 호출. 소멸 시점에는 다른 스레드가 큐를 쓰지 않음
+    size_t tail = m_tail.load(std::memory_order_acquire);
+    for (size_t pos = m_head.load(std::memory_order_relaxed); pos != tail; pos++)
+        m_slots[pos & m_mask].Data()->~T();
+
+    size_t bytes = sizeof(Slot) * (m_mask + 1);
+    if (m_arena)
+        m_arena->Release(m_slots, bytes);
+    else
+        ::operator delete(m_slots, std::align_val_t(SLOT_ALIGN));
+}
+
+template <typename T>
+inline size_t SPSCQueue<T>::FreeSlots(size_t tail, size_t count)
+{
+    size_t freeCount = (m_mask + 1) - (tail - m_cachedHead);
+    if (freeCount < count)
+    {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        freeCount = (m_mask + 1) - (tail - m_cachedHead);
+    }
+    return freeCount;
+}
+
+template <typename T>
+inline size_t SPSCQueue<T>::FilledSlots(size_t head, size_t count)
+{
+    size_t filledCount = m_cachedTail - head;
+    if (filledCount < count)
+    {
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+        filledCount = m_cachedTail - head;
+    }
+    return filledCount;
+}
+
+template <typename T>
+template <typename... Args>
+inline bool SPSCQueue<T>::try_emplace(Args&&... args)
+{
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (FreeSlots(tail, 1) == 0)
+        return false;
+
+    new (m_slots[tail & m_mask].storage) T(std::forward<Args>(args)...);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+template <typename InputIt>
+inline size_t SPSCQueue<T>::try_enqueue_bulk(InputIt first, size_t count)
+{
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t freeCount = FreeSlots(tail, count);
+    if (count > freeCount)
+        count = freeCount;
+
+    for (size_t i = 0; i < count; i++, ++first)
+        new (m_slots[(tail + i) & m_mask].storage) T(*first);
+
+    if (count)
+        m_tail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+template <typename T>
+inline bool SPSCQueue<T>::try_dequeue(T& data)
+{
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (FilledSlots(head, 1) == 0)
+        return false;
+
+    T* stored = m_slots[head & m_mask].Data();
+    data = std::move(*stored);
+    stored->~T();
+
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+template <typename OutputIt>
+inline size_t SPSCQueue<T>::try_dequeue_bulk(OutputIt out, size_t maxCount)
+{
+    size_t head = m_head.load(std::memory_order_relaxed);
+    size_t count = FilledSlots(head, maxCount);
+    if (count > maxCount)
+        count = maxCount;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        T* stored = m_slots[(head + i) & m_mask].Data();
+        *out = std::move(*stored);
+        ++out;
+        stored->~T();
+    }
+
+    if (count)
+        m_head.store(head + count, std::memory_order_release);
+    return count;
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+
+#include "Platform.h"
+
+// 카운터 하나를 나눠 담는 샤드 갯수. 스레드가 이보다 많으면 샤드를 나눠 씀
+#define SHARDED_COUNTER_SHARDS 16
+
+// 여러 스레드가 자주 더하고 가끔 읽기만 하는 통계용 카운터
+// 스레드마다 서로 다른 캐시 라인의 샤드에 더하고, 읽을 때만 모든 샤드를 합산함
+// 읽는 도중에도 더하기가 계속될 수 있으므로 Load 결과는 근사값
+class ShardedCounter
+{
+public:
+    ShardedCounter() = default;
+    ShardedCounter(const ShardedCounter&) = delete;
+    ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+    void Add(LONG64 value)
+    {
+        m_shards[ShardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void Sub(LONG64 value)
+    {
+        m_shards[ShardIndex()].value.fetch_sub(value, std::memory_order_relaxed);
+    }
+
+    // 모든 샤드의 합
+    LONG64 Load(void) const
+    {
+        LONG64 sum = 0;
+        for (const Shard& shard : m_shards)
+        {
+            sum += shard.value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    void Reset(void)
+    {
+        for (Shard& shard : m_shards)
+        {
+            shard.value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    // 현재 스레드가 사용할 샤드. 처음 호출될 때 스레드마다 돌아가며 배정
+    static UINT32 ShardIndex(void)
+    {
+        static std::atomic<UINT32> s_nextShard{ 0 };
+        thread_local UINT32 t_shard = UINT32_MAX;
+
+        if (t_shard == UINT32_MAX)
+        {
+            t_shard = s_nextShard.fetch_add(1, std::memory_order_relaxed) % SHARDED_COUNTER_SHARDS;
+        }
+
+        return t_shard;
+    }
+
+    struct alignas(CACHE_LINE_SIZE) Shard
+    {
+        std::atomic<LONG64> value{ 0 };
+    };
+
+    Shard m_shards[SHARDED_COUNTER_SHARDS];
+};
@@ -0,0 +1,264 @@
+﻿#pragma once
+
+#include "MemoryPool.h"
+#include <new>
+
+// 크기 클래스로 처리할 최대 요청 크기. 이보다 크면 operator new/delete 로 넘김
+#define SIZE_CLASS_MAX_SIZE 16384
+
+// 크기 -> 클래스 조회 테이블의 단위
+#define SIZE_CLASS_GRANULE 8
+
+// 크기 클래스 최대 갯수 (8, 16 ~ 128 까지 16바이트 간격 + 이후 2배 구간마다 4개)
+#define SIZE_CLASS_MAX_COUNT 64
+
+
+// 타입 없이 고정 크기 블록만 다루는 풀
+// 비어 있는 블록의 앞 8바이트를 next 로 사용하므로 블록 크기는 8바이트 이상이어야 함
+class RawPool
+{
+public:
+    RawPool(void) = default;
+    ~RawPool(void);
+
+    RawPool(const RawPool&) = delete;
+    RawPool& operator=(const RawPool&) = delete;
+
+    // 블록 크기와 슬랩을 잘라 올 아레나(nullptr이면 OS 페이지)를 정함. 사용하기 전에 한 번만 호출
+    void Init(UINT32 blockSize, SlabArena* arena = nullptr);
+
+    // 슬랩을 받아오지 못하면 nullptr
+    void* Alloc(void);
+    void Free(void* ptr);
+
+public:
+    UINT32 GetBlockSize(void) { return m_blockSize; }
+    UINT32 GetCurPoolCount(void) { LONG64 count = m_curPoolCount.Load(); return count > 0 ? static_cast<UINT32>(count) : 0; }
+    UINT32 GetMaxPoolCount(void) { LONG64 count = m_maxPoolCount.Load(); return count > 0 ? static_cast<UINT32>(count) : 0; }
+
+private:
+    // free 상태의 블록. TaggedFreeList 가 요구하는 next 필드만 있음
+    struct RawNode
+    {
+        UINT64 next;
+    };
+
+    RawNode* Block(SlabHeader* slab, UINT32 index)
+    {
+        return reinterpret_cast<RawNode*>(reinterpret_cast<char*>(slab) + SLAB_HEADER_SIZE + static_cast<size_t>(m_blockSize) * index);
+    }
+
+    size_t SlabSize(void) { return SLAB_HEADER_SIZE + static_cast<size_t>(m_blockSize) * m_slabNodeCount; }
+
+    // m_slabNodeCount 개의 블록을 담은 슬랩을 할당해 슬랩 목록에 등록. 블록들은 서로 연결된 상태. 실패하면 nullptr
+    SlabHeader* AllocSlab(void);
+
+private:
+    POOL_CACHE_ALIGN TaggedFreeList<RawNode> m_freeList;
+
+    ShardedCounter m_curPoolCount; // free list 에 있는 블록 갯수
+    ShardedCounter m_maxPoolCount; // 할당한 전체 블록 갯수
+
+    POOL_CACHE_ALIGN std::atomic<SlabHeader*> m_slabList{ nullptr };
+    UINT32 m_blockSize = 0;
+    UINT32 m_slabNodeCount = 0;
+    SlabArena* m_arena = nullptr; // 슬랩을 잘라 올 아레나, nullptr이면 OS 페이지
+};
+
+inline void RawPool::Init(UINT32 blockSize, SlabArena* arena)
+{
+    m_blockSize = blockSize;
+    m_arena = arena;
+
+    // MemoryPool 과 같은 규칙. 페이지 하나에 들어가는 만큼, 단 SLAB_MIN_NODE_COUNT 이상
+    size_t perPage = (SLAB_PAGE_SIZE - SLAB_HEADER_SIZE) / blockSize;
+    m_slabNodeCount = perPage < SLAB_MIN_NODE_COUNT ? SLAB_MIN_NODE_COUNT : static_cast<UINT32>(perPage);
+}
+
+inline RawPool::~RawPool(void)
+{
+    SlabHeader* slab = m_slabList.load(std::memory_order_acquire);
+    while (slab)
+    {
+        SlabHeader* nextSlab = slab->next;
+        if (m_arena)
+            m_arena->Release(slab, SlabSize());
+        else
+            PoolPageFree(slab, SlabSize());
+        slab = nextSlab;
+    }
+}
+
+inline SlabHeader* RawPool::AllocSlab(void)
+{
+    // MemoryPool 과 같이 페이지 경계로 받아옴 (0으로 채워져 있음). 아레나를 쓰면 아레나에서 잘라 옴
+    SlabHeader* slab;
+    if (m_arena)
+        slab = (SlabHeader*)m_arena->Allocate(SlabSize());
+    else
+        slab = (SlabHeader*)PoolPageAllocAligned(SlabSize(), PoolPageSize());
+
+    if (slab == nullptr)
+        return nullptr;
+
+    slab->nodeCount = m_slabNodeCount;
+
+    for (UINT32 i = 0; i < m_slabNodeCount; i++)
+    {
+        Block(slab, i)->next = (i + 1 < m_slabNodeCount) ? reinterpret_cast<UINT64>(Block(slab, i + 1)) : 0;
+    }
+
+    SlabHeader* currentHead = m_slabList.load(std::memory_order_relaxed);
+    do {
+        slab->next = currentHead;
+    } while (!m_slabList.compare_exchange_weak(currentHead, slab, std::memory_order_release, std::memory_order_relaxed));
+
+    m_maxPoolCount.Add(m_slabNodeCount);
+
+    return slab;
+}
+
+inline void* RawPool::Alloc(void)
+{
+    RawNode* node = m_freeList.Pop();
+    if (node)
+    {
+        m_curPoolCount.Sub(1);
+        return node;
+    }
+
+    // 비어 있다면 슬랩을 새로 할당해서 첫 블록은 반환, 나머지는 한 번의 CAS로 게시
+    SlabHeader* slab = AllocSlab();
+    if (slab == nullptr)
+        return nullptr;
+
+    if (m_slabNodeCount > 1)
+    {
+        m_freeList.PushChain(Block(slab, 1), Block(slab, m_slabNodeCount - 1));
+        m_curPoolCount.Add(m_slabNodeCount - 1);
+    }
+
+    return Block(slab, 0);
+}
+
+inline void RawPool::Free(void* ptr)
+{
+    RawNode* node = reinterpret_cast<RawNode*>(ptr);
+    m_freeList.PushChain(node, node);
+    m_curPoolCount.Add(1);
+}
+
+
+// 크기별로 나눈 RawPool 배열 앞에서 요청 크기에 맞는 풀로 보내주는 할당기
+// 128바이트까지는 16바이트 간격(8바이트 클래스 포함), 그 이후는 2배 구간마다 4등분하는 jemalloc 방식 간격
+// 요청 크기 대비 낭비는 최대 25% 정도
+class SizeClassPool
+{
+public:
+    // arena 를 주면 모든 클래스의 슬랩을 그 아레나에서 잘라 옴. 아레나는 풀보다 오래 살아야 함
+    explicit SizeClassPool(SlabArena* arena = nullptr);
+
+    SizeClassPool(const SizeClassPool&) = delete;
+    SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+    // size 바이트 이상의 블록을 반환. SIZE_CLASS_MAX_SIZE 보다 크면 operator new 사용
+    // operator new 와 같이 메모리를 받아오지 못하면 std::bad_alloc
+    void* Allocate(size_t size);
+
+    // Allocate 에 넘겼던 것과 같은 size 로 반환해야 함
+    void Deallocate(void* ptr, size_t size);
+
+    // 프로세스 전체에서 공유하는 기본 인스턴스
+    static SizeClassPool& GetDefault(void)
+    {
+        static SizeClassPool* instance = new SizeClassPool;
+        return *instance;
+    }
+
+public:
+    UINT32 GetClassCount(void) { return m_classCount; }
+    UINT32 GetClassSize(UINT32 classIndex) { return m_pools[classIndex].GetBlockSize(); }
+
+    // 요청 크기가 들어갈 클래스 번호
+    UINT32 GetClassIndex(size_t size) { return m_classIndex[(size + SIZE_CLASS_GRANULE - 1) / SIZE_CLASS_GRANULE]; }
+
+    RawPool& GetClassPool(UINT32 classIndex) { return m_pools[classIndex]; }
+
+private:
+    RawPool m_pools[SIZE_CLASS_MAX_COUNT];
+    UINT32 m_classCount = 0;
+
+    // (size + 7) / 8 -> 클래스 번호
+    UINT8 m_classIndex[SIZE_CLASS_MAX_SIZE / SIZE_CLASS_GRANULE + 1];
+};
+
+inline SizeClassPool::SizeClassPool(SlabArena* arena)
+{
+    UINT32 classSizes[SIZE_CLASS_MAX_COUNT];
+    UINT32 count = 0;
+
+    // 8, 16, 32, 48, ... 128
+    classSizes[count++] = 8;
+    for (UINT32 size = 16; size <= 128; size += 16)
+    {
+        classSizes[count++] = size;
+    }
+
+    // 128 이후로는 [base, 2*base] 구간을 4등분
+    for (UINT32 base = 128; base < SIZE_CLASS_MAX_SIZE; base *= 2)
+    {
+        for (UINT32 step = 1; step <= 4; step++)
+        {
+            classSizes[count++] = base + step * (base / 4);
+        }
+    }
+
+    m_classCount = count;
+    for (UINT32 i = 0; i < count; i++)
+    {
+        m_pools[i].Init(classSizes[i], arena);
+    }
+
+    // 조회 테이블 채우기. 크기 0 은 가장 작은 클래스로
+    UINT32 classIndex = 0;
+    for (UINT32 i = 0; i <= SIZE_CLASS_MAX_SIZE / SIZE_CLASS_GRANULE; i++)
+    {
+        while (classSizes[classIndex] < i * SIZE_CLASS_GRANULE)
+        {
+            classIndex++;
+        }
+        m_classIndex[i] = static_cast<UINT8>(classIndex);
+    }
+}
+
+inline void* SizeClassPool::Allocate(size_t size)
+{
+    if (size > SIZE_CLASS_MAX_SIZE)
+    {
+        return ::operator new(size);
+    }
+
+    void* ptr = m_pools[GetClassIndex(size)].Alloc();
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+inline void SizeClassPool::Deallocate(void* ptr, size_t size)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+
+    if (size > SIZE_CLASS_MAX_SIZE)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+
+    m_pools[GetClassIndex(size)].Free(ptr);
+}
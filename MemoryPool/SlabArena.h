@@ -0,0 +1,280 @@
+﻿#pragma once
+
+#include <mutex>
+#include "Platform.h"
+
+// 아레나가 한 번에 예약하는 영역 크기 기본값
+#define SLAB_ARENA_CHUNK_SIZE (64ull * 1024 * 1024)
+
+// 대형 페이지 크기. 청크는 항상 이 크기에 맞춰 정렬하고 이 크기의 배수로 예약
+#define SLAB_ARENA_HUGE_PAGE_SIZE (2ull * 1024 * 1024)
+
+
+// 아레나가 사용할 페이지 종류
+enum class ArenaPageMode
+{
+    Normal,         // 일반 4KB 페이지
+    Transparent,    // 일반 페이지로 받고 커널에 대형 페이지로 합쳐달라고 요청 (Linux THP)
+    Explicit,       // 미리 예약된 대형 페이지를 직접 요청 (MAP_HUGETLB / MEM_LARGE_PAGES). 실패하면 Transparent, Normal 순서로 대체
+};
+
+
+// 풀 슬랩을 잘라 줄 큰 가상 메모리 영역
+// 슬랩마다 malloc/mmap을 부르지 않고 큰 청크를 예약해서 앞에서부터 잘라 줌
+// 같은 타입의 객체가 대형 페이지 몇 개에 모이므로 객체 수가 많아져도 TLB miss가 덜 남
+// 잘라 준 메모리는 개별로 해제하지 않고 아레나가 소멸할 때 한꺼번에 반환하므로, 아레나는 이를 쓰는 풀보다 오래 살아야 함
+class SlabArena
+{
+public:
+    explicit SlabArena(ArenaPageMode mode = ArenaPageMode::Transparent, size_t chunkSize = SLAB_ARENA_CHUNK_SIZE);
+    ~SlabArena(void);
+
+    SlabArena(const SlabArena&) = delete;
+    SlabArena& operator=(const SlabArena&) = delete;
+
+    // 페이지 경계에 맞춘 bytes 크기의 메모리를 잘라 줌. 0으로 채워져 있음. 실패하면 nullptr
+    // alignment(2의 거듭제곱)를 주면 시작 주소를 그 경계에 맞춤. 정렬하느라 건너뛴 공간은 버림
+    void* Allocate(size_t bytes, size_t alignment = 0);
+
+    // 잘라 준 메모리를 더 쓰지 않음. 주소 공간은 아레나에 남기고 물리 메모리만 OS에 반환. 실제로 반환한 바이트 수를 리턴
+    // 미리 예약된 대형 페이지로 받은 청크는 대형 페이지 단위로만 반환할 수 있으므로, 범위 안에 온전히 들어가는 대형 페이지만 반환
+    size_t Release(void* ptr, size_t bytes);
+
+public:
+    // 요청한 페이지 종류
+    ArenaPageMode GetRequestedMode(void) { return m_requestedMode; }
+
+    // 실제로 받은 페이지 종류. Explicit을 요청했어도 대형 페이지가 없으면 낮은 단계로 내려감
+    // 아래 값들은 Allocate 중에 바뀌므로 락을 잡고 읽음
+    ArenaPageMode GetActualMode(void) { std::lock_guard<std::mutex> lk(m_lock); return m_actualMode; }
+
+    // 예약한 전체 크기 / 잘라 준 크기
+    size_t GetReservedBytes(void) { std::lock_guard<std::mutex> lk(m_lock); return m_reservedBytes; }
+    size_t GetUsedBytes(void) { std::lock_guard<std::mutex> lk(m_lock); return m_usedBytes; }
+
+private:
+    // 청크 하나. 아레나 소멸 시 해제하기 위해 청크 앞에 목록을 기록
+    struct ChunkHeader
+    {
+        ChunkHeader* next;
+        size_t bytes;
+        bool bHugeTlb;  // 미리 예약된 대형 페이지(Explicit)로 받은 청크
+    };
+
+    // bytes 이상의 청크를 새로 예약해서 현재 청크로 설정
+    bool AllocChunk(size_t bytes);
+
+    // 대형 페이지 경계로 정렬된 영역을 mode에 맞게 받아옴. 실패하면 nullptr
+    // THP 요청이 거부되면 일반 페이지로 받고 mode를 Normal로 바꿈
+    static void* MapRegion(size_t bytes, ArenaPageMode& mode);
+    static void UnmapRegion(void* ptr, size_t bytes);
+
+    // ptr이 Explicit 모드로 받은 청크 안에 있는지
+    bool IsHugeTlbChunk(void* ptr);
+
+private:
+    std::mutex m_lock;              // 슬랩 할당은 드문 경로이므로 락으로 충분
+
+    ChunkHeader* m_chunkList = nullptr;
+    UINT32 m_hugeTlbChunkCount = 0; // Explicit 모드로 받은 청크 수. 0이면 Release에서 청크를 찾지 않음
+    char* m_cur = nullptr;          // 현재 청크에서 다음에 잘라 줄 위치
+    char* m_end = nullptr;          // 현재 청크의 끝
+
+    ArenaPageMode m_requestedMode;
+    ArenaPageMode m_actualMode;
+    size_t m_chunkSize;
+    size_t m_reservedBytes = 0;
+    size_t m_usedBytes = 0;
+};
+
+inline SlabArena::SlabArena(ArenaPageMode mode, size_t chunkSize)
+{
+    m_requestedMode = mode;
+    m_actualMode = mode;
+
+    // 청크는 대형 페이지 단위로 예약
+    m_chunkSize = (chunkSize + SLAB_ARENA_HUGE_PAGE_SIZE - 1) & ~(SLAB_ARENA_HUGE_PAGE_SIZE - 1);
+    if (m_chunkSize == 0)
+        m_chunkSize = SLAB_ARENA_HUGE_PAGE_SIZE;
+}
+
+inline SlabArena::~SlabArena(void)
+{
+    ChunkHeader* chunk = m_chunkList;
+    while (chunk)
+    {
+        ChunkHeader* nextChunk = chunk->next;
+        UnmapRegion(chunk, chunk->bytes);
+        chunk = nextChunk;
+    }
+
+    m_chunkList = nullptr;
+}
+
+inline void* SlabArena::Allocate(size_t bytes, size_t alignment)
+{
+    bytes = PoolPageRound(bytes);
+    if (alignment < PoolPageSize())
+        alignment = PoolPageSize();
+
+    std::lock_guard<std::mutex> lk(m_lock);
+
+    // 현재 청크에 남은 공간이 모자라면 새 청크를 예약. 남은 공간은 버림
+    char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(m_cur) + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if (m_cur == nullptr || aligned > m_end || static_cast<size_t>(m_end - aligned) < bytes)
+    {
+        // 새 청크는 대형 페이지 경계에서 시작하고 첫 페이지는 청크 헤더이므로, 정렬 여유분을 더해서 요청
+        if (!AllocChunk(alignment > PoolPageSize() ? bytes + alignment : bytes))
+            return nullptr;
+        aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(m_cur) + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+
+    void* ptr = aligned;
+    m_usedBytes += (aligned + bytes) - m_cur;
+    m_cur = aligned + bytes;
+
+    return ptr;
+}
+
+inline size_t SlabArena::Release(void* ptr, size_t bytes)
+{
+    bytes = PoolPageRound(bytes);
+    if (!IsHugeTlbChunk(ptr))
+        return PoolPageDiscard(ptr, bytes) ? bytes : 0;
+
+#if defined(_WIN32)
+    // 대형 페이지는 MEM_RESET을 지원하지 않으므로 반환하지 않음
+    return 0;
+#else
+    // 대형 페이지보다 작은 범위에 madvise하면 EINVAL로 실패하므로 범위 안쪽으로 대형 페이지 경계에 맞춤
+    // 이전 커널은 hugetlb 영역의 MADV_DONTNEED를 지원하지 않으므로 결과를 확인해서 반환한 만큼만 셈
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(ptr) + SLAB_ARENA_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(SLAB_ARENA_HUGE_PAGE_SIZE - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + bytes) & ~(uintptr_t)(SLAB_ARENA_HUGE_PAGE_SIZE - 1);
+    if (end <= begin)
+        return 0;
+
+    return (madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED) == 0) ? static_cast<size_t>(end - begin) : 0;
+#endif // _WIN32
+}
+
+inline bool SlabArena::IsHugeTlbChunk(void* ptr)
+{
+    std::lock_guard<std::mutex> lk(m_lock);
+    if (m_hugeTlbChunkCount == 0)
+        return false;
+
+    char* p = reinterpret_cast<char*>(ptr);
+    for (ChunkHeader* chunk = m_chunkList; chunk; chunk = chunk->next)
+    {
+        char* begin = reinterpret_cast<char*>(chunk);
+        if (p >= begin && p < begin + chunk->bytes)
+            return chunk->bHugeTlb;
+    }
+    return false;
+}
+
+inline bool SlabArena::AllocChunk(size_t bytes)
+{
+    // 청크 헤더가 첫 페이지를 차지하므로 그만큼 더 예약
+    size_t need = bytes + PoolPageSize();
+    size_t chunkBytes = (need > m_chunkSize) ? ((need + SLAB_ARENA_HUGE_PAGE_SIZE - 1) & ~(SLAB_ARENA_HUGE_PAGE_SIZE - 1)) : m_chunkSize;
+
+    // 요청한 단계부터 차례로 내려가며 시도. 한 번 내려간 단계는 이후 청크에서도 유지
+    void* region = nullptr;
+    while (true)
+    {
+        region = MapRegion(chunkBytes, m_actualMode);
+        if (region || m_actualMode == ArenaPageMode::Normal)
+            break;
+
+        m_actualMode = (m_actualMode == ArenaPageMode::Explicit) ? ArenaPageMode::Transparent : ArenaPageMode::Normal;
+    }
+
+    if (region == nullptr)
+        return false;
+
+    ChunkHeader* chunk = reinterpret_cast<ChunkHeader*>(region);
+    chunk->bytes = chunkBytes;
+    chunk->bHugeTlb = (m_actualMode == ArenaPageMode::Explicit);
+    chunk->next = m_chunkList;
+    m_chunkList = chunk;
+
+    if (chunk->bHugeTlb)
+        m_hugeTlbChunkCount++;
+
+    m_cur = reinterpret_cast<char*>(region) + PoolPageSize();
+    m_end = reinterpret_cast<char*>(region) + chunkBytes;
+    m_reservedBytes += chunkBytes;
+
+    return true;
+}
+
+inline void* SlabArena::MapRegion(size_t bytes, ArenaPageMode& mode)
+{
+#if defined(_WIN32)
+    if (mode == ArenaPageMode::Explicit)
+    {
+        // SeLockMemoryPrivilege 권한이 없으면 실패하므로 호출한 쪽에서 일반 페이지로 대체
+        size_t largePage = GetLargePageMinimum();
+        if (largePage == 0 || bytes % largePage != 0)
+            return nullptr;
+
+        return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    }
+
+    // Windows에는 THP가 없으므로 Transparent는 일반 페이지와 같음
+    mode = ArenaPageMode::Normal;
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+#if defined(MAP_HUGETLB)
+    if (mode == ArenaPageMode::Explicit)
+    {
+        // 미리 예약된 대형 페이지(vm.nr_hugepages)가 모자라면 실패
+        void* ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        return (ptr == MAP_FAILED) ? nullptr : ptr;
+    }
+#else
+    if (mode == ArenaPageMode::Explicit)
+        return nullptr;
+#endif // MAP_HUGETLB
+
+    // 대형 페이지 경계에 맞추기 위해 한 페이지 더 크게 예약하고 앞뒤를 잘라냄
+    size_t mapBytes = bytes + SLAB_ARENA_HUGE_PAGE_SIZE;
+    void* raw = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+        return nullptr;
+
+    UINT64 rawAddr = reinterpret_cast<UINT64>(raw);
+    UINT64 alignedAddr = (rawAddr + SLAB_ARENA_HUGE_PAGE_SIZE - 1) & ~(SLAB_ARENA_HUGE_PAGE_SIZE - 1);
+    size_t head = static_cast<size_t>(alignedAddr - rawAddr);
+    size_t tail = mapBytes - head - bytes;
+
+    if (head > 0)
+        munmap(raw, head);
+    if (tail > 0)
+        munmap(reinterpret_cast<char*>(alignedAddr) + bytes, tail);
+
+    if (mode == ArenaPageMode::Transparent)
+    {
+        // THP를 지원하지 않는 커널이면 실패하지만 일반 페이지로 그대로 사용
+#if defined(MADV_HUGEPAGE)
+        if (madvise(reinterpret_cast<void*>(alignedAddr), bytes, MADV_HUGEPAGE) != 0)
+            mode = ArenaPageMode::Normal;
+#else
+        mode = ArenaPageMode::Normal;
+#endif // MADV_HUGEPAGE
+    }
+
+    return reinterpret_cast<void*>(alignedAddr);
+#endif // _WIN32
+}
+
+inline void SlabArena::UnmapRegion(void* ptr, size_t bytes)
+{
+#if defined(_WIN32)
+    (void)bytes;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, bytes);
+#endif // _WIN32
+}
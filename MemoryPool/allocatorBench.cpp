@@ -0,0 +1,95 @@
+﻿
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <algorithm>
+#include "PoolAllocator.h"
+
+#define REPEAT_COUNT 50
+#define KEY_COUNT 20000
+
+// 스레드마다 같은 순서의 키를 쓰도록 시드 고정
+std::vector<int> MakeKeys(size_t count)
+{
+    std::vector<int> keys(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        keys[i] = static_cast<int>(i);
+    }
+
+    std::mt19937 rng(12345);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    return keys;
+}
+
+// map 에 키를 모두 넣고 다시 모두 지우는 것을 반복. 노드 할당/해제가 대부분을 차지함
+template <typename MapType, typename... Args>
+void InsertErase(const std::vector<int>& keys, Args&&... args)
+{
+    MapType m(std::forward<Args>(args)...);
+
+    for (int k = 0; k < REPEAT_COUNT; ++k)
+    {
+        for (int key : keys)
+        {
+            m.emplace(key, key);
+        }
+
+        for (int key : keys)
+        {
+            m.erase(key);
+        }
+    }
+}
+
+void testDefault(const std::vector<int>& keys)
+{
+    InsertErase<std::map<int, int>>(keys);
+}
+
+void testPoolAllocator(const std::vector<int>& keys)
+{
+    InsertErase<std::map<int, int, std::less<int>, PoolAllocator<std::pair<const int, int>>>>(keys);
+}
+
+void testPmrResource(const std::vector<int>& keys)
+{
+    InsertErase<std::pmr::map<int, int>>(keys, PoolMemoryResource::GetDefault());
+}
+
+typedef void (*TestFunc)(const std::vector<int>&);
+
+// 멀티스레드 벤치마크 헬퍼. 스레드마다 자신의 map 을 가짐
+void runInThreads(TestFunc fn, const std::vector<int>& keys, int threads, const char* name)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> ths;
+    ths.reserve(threads);
+    for (int t = 0; t < threads; ++t)
+    {
+        ths.emplace_back(fn, std::cref(keys));
+    }
+    for (auto& th : ths) th.join();
+    auto end = std::chrono::high_resolution_clock::now();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    std::cout << "[" << name << " x" << threads << "] " << ms << " ms\n";
+}
+
+int main()
+{
+    std::vector<int> keys = MakeKeys(KEY_COUNT);
+
+    std::cout << "--- map insert/erase (" << KEY_COUNT << " keys x " << REPEAT_COUNT << ") ---\n";
+    for (int t : {1, 2, 4, 8}) {
+        std::cout << "\n--- " << t << " threads ---\n";
+        runInThreads(testDefault, keys, t, "std::allocator");
+        runInThreads(testPoolAllocator, keys, t, "PoolAllocator");
+        runInThreads(testPmrResource, keys, t, "PoolMemoryResource");
+    }
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+﻿
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <string>
+#include "MemoryPool.h"
+
+// 기본 객체 수. 512바이트 x 100만 = 512MB. 인자로 바꿀 수 있음 (예: arenaBench 4000000)
+#define DEFAULT_OBJECT_COUNT 1000000
+
+// 포인터를 따라가는 횟수 = 객체 수 x CHASE_ROUND
+#define CHASE_ROUND 4
+
+// excelBench의 Foo와 같은 512바이트 객체. 앞 8바이트를 무작위 순환의 다음 객체 포인터로 사용
+struct Foo {
+    Foo* next;
+    int x[126];
+};
+
+const char* ModeName(ArenaPageMode mode)
+{
+    switch (mode)
+    {
+    case ArenaPageMode::Normal:         return "normal";
+    case ArenaPageMode::Transparent:    return "transparent huge";
+    case ArenaPageMode::Explicit:       return "explicit huge";
+    }
+    return "?";
+}
+
+// 객체들을 무작위 순서의 순환으로 연결하고 따라가며 접근 한 번당 시간을 잼
+// 다음 주소가 이전 접근 결과에 달려 있으므로 캐시/TLB miss가 그대로 드러남
+double ChaseRandom(std::vector<Foo*>& objects)
+{
+    std::mt19937_64 rng(12345);
+    std::vector<Foo*> order(objects);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i]->next = order[(i + 1) % order.size()];
+        order[i]->x[0] = static_cast<int>(i);
+    }
+
+    size_t steps = order.size() * CHASE_ROUND;
+    Foo* p = order[0];
+    long long sum = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < steps; ++i)
+    {
+        sum += p->x[0];
+        p = p->next;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // 최적화로 루프가 사라지지 않도록 결과를 사용
+    if (sum == -1)
+        std::cout << sum;
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / steps;
+}
+
+void Report(const std::string& name, double ns, std::chrono::high_resolution_clock::time_point allocStart, std::chrono::high_resolution_clock::time_point allocEnd)
+{
+    auto allocMs = std::chrono::duration_cast<std::chrono::milliseconds>(allocEnd - allocStart).count();
+    std::cout << "[" << name << "] alloc " << allocMs << " ms, random access " << ns << " ns/access\n";
+}
+
+void testNewDelete(size_t count)
+{
+    std::vector<Foo*> objects;
+    objects.reserve(count);
+
+    auto allocStart = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; ++i)
+        objects.push_back(new Foo{});
+    auto allocEnd = std::chrono::high_resolution_clock::now();
+
+    Report("new/delete", ChaseRandom(objects), allocStart, allocEnd);
+
+    for (Foo* p : objects)
+        delete p;
+}
+
+// arena가 nullptr이면 슬랩마다 OS 페이지를 따로 받는 기본 풀
+void testPool(size_t count, SlabArena* arena, const std::string& name)
+{
+    std::vector<Foo*> objects;
+    objects.reserve(count);
+
+    MemoryPool<Foo, false> pool(0, 0, true, arena);
+
+    auto allocStart = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; ++i)
+        objects.push_back(pool.Alloc());
+    auto allocEnd = std::chrono::high_resolution_clock::now();
+
+    std::string label = name;
+    if (arena)
+        label += std::string(" -> ") + ModeName(arena->GetActualMode());
+
+    Report(label, ChaseRandom(objects), allocStart, allocEnd);
+
+    for (Foo* p : objects)
+        pool.Free(p);
+}
+
+void testArena(size_t count, ArenaPageMode mode, const std::string& name)
+{
+    SlabArena arena(mode);
+    testPool(count, &arena, name);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t count = (argc > 1) ? std::stoull(argv[1]) : DEFAULT_OBJECT_COUNT;
+
+    std::cout << "--- random access over " << count << " x " << sizeof(Foo) << " bytes ("
+        << (count * sizeof(Foo)) / (1024 * 1024) << " MB) ---\n";
+
+    testNewDelete(count);
+    testPool(count, nullptr, "MemoryPool");
+    testArena(count, ArenaPageMode::Normal, "MemoryPool + arena[normal]");
+    testArena(count, ArenaPageMode::Transparent, "MemoryPool + arena[transparent]");
+    testArena(count, ArenaPageMode::Explicit, "MemoryPool + arena[explicit]");
+
+    return 0;
+}
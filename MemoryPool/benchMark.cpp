@@ -43,11 +43,15 @@ void testNewDelete(size_t count, int threadCnt) {
     alloc = threads + alloc;
     free = threads + free;
 
+    // 구간마다 이름을 복사하지 않도록 측정 전에 태그를 등록
+    ProfileTagId allocTag = ProfileRegisterTag(alloc);
+    ProfileTagId freeTag = ProfileRegisterTag(free);
+
     auto start = std::chrono::high_resolution_clock::now();
 
     for (int k = 0; k < REPEAT_COUNT; ++k)
     {
-        Profile pf(alloc);
+        ProfileScope pf(allocTag);
         for (size_t i = 0; i < count; ++i) {
             v[k].push_back(new Foo{int(i)});
         }
@@ -55,7 +59,7 @@ void testNewDelete(size_t count, int threadCnt) {
 
     for (int k = 0; k < REPEAT_COUNT; ++k)
     {
-        Profile pf(free);
+        ProfileScope pf(freeTag);
         for (Foo* p : v[k]) {
             delete p;
         }
@@ -132,7 +136,7 @@ void testTlsPool(size_t count, int threadCnt) {
         v[k].clear();
     }
 
-    std::cout << tlsPool.m_maxPoolCount << "\n";
+    std::cout << tlsPool.GetMaxPoolCount() << "\n";
 
     std::wstring threads = std::to_wstring(threadCnt);
     threads += {L" threads "};
@@ -145,11 +149,15 @@ void testTlsPool(size_t count, int threadCnt) {
     alloc = threads + alloc;
     free = threads + free;
 
+    // 구간마다 이름을 복사하지 않도록 측정 전에 태그를 등록
+    ProfileTagId allocTag = ProfileRegisterTag(alloc);
+    ProfileTagId freeTag = ProfileRegisterTag(free);
+
     auto start = std::chrono::high_resolution_clock::now();
 
     for (int k = 0; k < REPEAT_COUNT; ++k)
     {
-        Profile pf(alloc);
+        ProfileScope pf(allocTag);
         for (size_t i = 0; i < count; ++i) {
             v[k].push_back(tlsPool.Alloc());
         }
@@ -158,7 +166,7 @@ void testTlsPool(size_t count, int threadCnt) {
     for (int k = 0; k < REPEAT_COUNT; ++k)
     {
         {
-            Profile pf(free);
+            ProfileScope pf(freeTag);
             for (Foo* p : v[k]) {
                 tlsPool.Free(p);
             }
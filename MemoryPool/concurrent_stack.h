@@ -1,96 +1,372 @@
 #pragma once
 
-#include <Windows.h>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include "Platform.h"
+#include "EpochReclaimer.h"
+#include "MemoryPool.h"
+#include "Backoff.h"
 
-template <typename T>
+// LockFreeStack 노드 할당 정책
+// Allocate는 생성하지 않은 노드 공간을 넘기고, Deallocate는 소멸자를 호출한 노드 공간을 받음
+// Deallocate는 EpochReclaimer가 나중에 다른 스레드에서 호출하므로 스택 객체가 사라진 뒤에도 쓸 수 있는 정적 함수여야 함
+
+// 노드 타입별 전역 MemoryPool에서 노드를 받음 (기본값)
+// 풀의 매거진(스레드별 캐시)을 거치므로 Push/Pop이 힙 락을 잡지 않음
+template <typename NodeType>
+struct PoolNodeAllocator
+{
+    static void* Allocate(void) { return GetPool().Alloc(); }
+    static void Deallocate(void* ptr) { GetPool().Free(static_cast<PoolRawStorage<NodeType>*>(ptr)); }
+
+private:
+    // 노드는 스택이 직접 생성/소멸하므로 풀에서는 메모리만 받음 (침투형 배치에서도 쓸 수 있도록 PoolRawStorage)
+    // 회수가 늦게 일어나도 안전하도록 일부러 해제하지 않음
+    static MemoryPool<PoolRawStorage<NodeType>, true>& GetPool(void)
+    {
+        static MemoryPool<PoolRawStorage<NodeType>, true>* pool = new MemoryPool<PoolRawStorage<NodeType>, true>;
+        return *pool;
+    }
+};
+
+// 노드마다 전역 new/delete를 호출 (비교용)
+template <typename NodeType>
+struct NewDeleteNodeAllocator
+{
+    static void* Allocate(void) { return ::operator new(sizeof(NodeType)); }
+    static void Deallocate(void* ptr) { ::operator delete(ptr); }
+};
+
+template <typename T, template <typename> class NodeAllocator = PoolNodeAllocator>
 class LockFreeStack {
 private:
     struct Node {
         T data;
         Node* next;
 
-        Node(T _data, Node* _next) : data{ _data }, next{ _next } {}
+        // data는 풀에서 받은 노드 공간에 바로 생성됨. 복사 없이 인자를 그대로 T의 생성자로 넘김
+        template <typename... Args>
+        explicit Node(Node* _next, Args&&... args) : data(std::forward<Args>(args)...), next{ _next } {}
     };
 
+    using Allocator = NodeAllocator<Node>;
+
+    // Pop한 노드는 다른 스레드가 아직 next를 읽고 있을 수 있으므로 EpochReclaimer를 거쳐 해제
+    static void DeleteNode(void* ptr, size_t)
+    {
+        Node* node = static_cast<Node*>(ptr);
+        node->~Node();
+        Allocator::Deallocate(node);
+    }
+
+    // 한 번에 떼어낸 체인을 Retire 한 번으로 넘길 때 사용. 앞에서부터 count개 (CHAIN_TO_END면 next가 null인 노드까지) 해제
+    // 떼어낸 체인의 마지막 next는 다른 스레드가 읽고 있을 수 있어 null로 끊지 않으므로 개수를 함께 넘김
+    static constexpr size_t CHAIN_TO_END = static_cast<size_t>(-1);
+
+    static void DeleteChain(void* ptr, size_t count)
+    {
+        Node* node = static_cast<Node*>(ptr);
+        for (size_t i = 0; i < count && node; i++)
+        {
+            Node* nextNode = node->next;
+            DeleteNode(node, 0);
+            node = nextNode;
+        }
+    }
+
     struct AddressConverter {
-        static constexpr UINT64 POINTER_MASK = 0x00007FFFFFFFFFFF; //  47Ʈ
+        static constexpr UINT64 POINTER_MASK = 0x00007FFFFFFFFFFF; // 하위 47비트
         static constexpr UINT64 STAMP_SHIFT = 47;
 
-        //  ּҿ stamp ߰
+        // 노드 주소에 stamp 추가
         static UINT64 AddStamp(Node* node, UINT64 stamp) {
             UINT64 pointerValue = reinterpret_cast<UINT64>(node);
             return (pointerValue & POINTER_MASK) | (stamp << STAMP_SHIFT);
         }
 
-        //  ּ 
+        // 노드 주소 추출
         static Node* ExtractNode(UINT64 taggedPointer) {
             return reinterpret_cast<Node*>(taggedPointer & POINTER_MASK);
         }
-    };
 
-    bool CAS(UINT64* target, UINT64 expected, UINT64 desired) {
-        return InterlockedCompareExchange64(reinterpret_cast<LONG64*>(target), desired, expected) == expected;
-    }
+        // top 에 들어있던 stamp 의 다음 값. 전역 stamp 카운터를 두면 모든 Push/Pop이 그 캐시 라인도 두고 경쟁하므로 top에서 이어감
+        static UINT64 NextStamp(UINT64 taggedPointer) {
+            return (taggedPointer >> STAMP_SHIFT) + 1;
+        }
+    };
 
 public:
-    LockFreeStack() : top(0), stamp(0) {}
+    // bUseElimination : top CAS에 실패했을 때 제거 배열에서 반대 연산과 만나 보는지
+    // 스레드가 적거나 Push/Pop이 한쪽으로 몰리는 경우라면 꺼도 됨 (지수 백오프만 사용)
+    explicit LockFreeStack(bool bUseElimination = true) : m_bUseElimination(bUseElimination), top(0) {}
 
+    // 스택을 파괴하는 시점에는 다른 스레드가 노드를 읽고 있지 않으므로 Retire하지 않고 바로 해제
+    // T를 꺼내지 않으므로 기본 생성자가 없는 T도 쓸 수 있음
     ~LockFreeStack() {
-        T value;
-        while (Pop(value));
+        DeleteChain(AddressConverter::ExtractNode(top.load(std::memory_order_acquire)), CHAIN_TO_END);
     }
 
-    void Push(const T& value)
+    void Push(const T& value) { Emplace(value); }
+    void Push(T&& value) { Emplace(std::move(value)); }
+
+    // 노드 공간에 T를 args로 바로 생성해서 올림
+    template <typename... Args>
+    void Emplace(Args&&... args)
     {
-        Node* newNode = new Node{ value, nullptr };
+        Node* newNode = NewNode(nullptr, std::forward<Args>(args)...);
         Node* currentNode;
 
-        UINT64 stValue = InterlockedIncrement(&stamp);
         UINT64 currentTop;
         UINT64 newTop;
+        ExponentialBackoff backoff;
 
         while (true) {
-            currentTop = top;
+            currentTop = top.load(std::memory_order_acquire);
             currentNode = AddressConverter::ExtractNode(currentTop);
 
-            newNode->next = currentNode; // ο  next  top 
+            newNode->next = currentNode; // 새로운 노드의 next를 현재 top으로 설정
 
-            newTop = AddressConverter::AddStamp(newNode, stValue);
+            newTop = AddressConverter::AddStamp(newNode, AddressConverter::NextStamp(currentTop));
 
             if (CAS(&top, currentTop, newTop)) {
-                break; //  Push Ϸ
+                break; // 성공적으로 Push 완료
             }
+
+            // 경합 중이라면 동시에 Pop하려는 스레드에게 노드를 직접 넘겨 봄
+            if (m_bUseElimination && m_elimination.TryPush(newNode)) {
+                break;
+            }
+
+            backoff.Pause();
         }
     }
 
+    // [first, last) 범위를 지역적으로 이어 붙인 뒤 CAS 한 번으로 올림
+    // 범위의 마지막 원소가 top이 되므로, 하나씩 Push한 것과 같은 순서로 Pop됨
+    template <typename InputIt>
+    void PushRange(InputIt first, InputIt last)
+    {
+        if (first == last)
+            return;
+
+        // 첫 원소가 체인의 맨 아래(tail), 마지막 원소가 맨 위(head)
+        // std::make_move_iterator로 감싸서 넘기면 원소를 옮겨 담음
+        Node* tail = NewNode(nullptr, *first);
+        Node* head = tail;
+        for (++first; first != last; ++first)
+            head = NewNode(head, *first);
+
+        UINT64 currentTop;
+        UINT64 newTop;
+        ExponentialBackoff backoff;
+
+        while (true) {
+            currentTop = top.load(std::memory_order_acquire);
+            tail->next = AddressConverter::ExtractNode(currentTop);
+
+            newTop = AddressConverter::AddStamp(head, AddressConverter::NextStamp(currentTop));
+
+            if (CAS(&top, currentTop, newTop)) {
+                break;
+            }
+
+            backoff.Pause();
+        }
+    }
+
+    // PopAll로 떼어낸 노드 체인. top에 있던 노드부터 (Pop 순서대로) 순회함
+    // 소멸할 때 체인 전체를 EpochReclaimer에 한 번에 넘김
+    class Chain {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = T*;
+            using reference = T&;
+
+            explicit iterator(Node* node = nullptr) : m_node(node) {}
+
+            T& operator*() const { return m_node->data; }
+            T* operator->() const { return &m_node->data; }
+            iterator& operator++() { m_node = m_node->next; return *this; }
+            iterator operator++(int) { iterator prev = *this; m_node = m_node->next; return prev; }
+            bool operator==(const iterator& other) const { return m_node == other.m_node; }
+            bool operator!=(const iterator& other) const { return m_node != other.m_node; }
+
+        private:
+            Node* m_node;
+        };
+
+        explicit Chain(Node* head = nullptr) : m_head(head) {}
+        Chain(Chain&& other) noexcept : m_head(other.m_head) { other.m_head = nullptr; }
+        Chain& operator=(Chain&& other) noexcept {
+            if (this != &other) {
+                Release();
+                m_head = other.m_head;
+                other.m_head = nullptr;
+            }
+            return *this;
+        }
+        Chain(const Chain&) = delete;
+        Chain& operator=(const Chain&) = delete;
+        ~Chain() { Release(); }
+
+        iterator begin() const { return iterator(m_head); }
+        iterator end() const { return iterator(); }
+        bool empty() const { return m_head == nullptr; }
+
+    private:
+        // 떼어내기 직전까지 다른 스레드가 이 노드들의 next를 읽고 있었을 수 있으므로 바로 해제하지 않음
+        void Release() {
+            if (m_head) {
+                EpochReclaimer::Retire(m_head, &DeleteChain, CHAIN_TO_END);
+                m_head = nullptr;
+            }
+        }
+
+        Node* m_head;
+    };
+
+    // top을 null로 한 번 바꿔 스택 전체를 떼어냄
+    // stamp는 그대로 두지만, 떼어낸 노드는 Chain이 Retire하므로 Pop 보호 구간에 있는 스레드가 빠져나가기 전에는
+    // 같은 주소로 다시 올라오지 않아 ABA가 생기지 않음
+    Chain PopAll() {
+        UINT64 oldTop = top.fetch_and(~AddressConverter::POINTER_MASK, std::memory_order_acq_rel);
+        return Chain(AddressConverter::ExtractNode(oldTop));
+    }
+
+    // 최대 n개를 CAS 한 번으로 떼어내 out에 top부터 차례로 씀. 떼어낸 개수를 반환 (비어 있다면 0)
+    template <typename OutputIt>
+    size_t TryPopN(OutputIt out, size_t n) {
+        if (n == 0)
+            return 0;
+
+        Node* currentNode;
+        Node* lastNode;
+        UINT64 currentTop;
+        UINT64 newTop;
+        size_t count;
+        ExponentialBackoff backoff;
+
+        // Pop과 같이 노드의 next를 따라가는 동안 그 노드가 해제되지 않도록 보호 구간에 들어감
+        EpochGuard guard;
+
+        while (true) {
+            currentTop = top.load(std::memory_order_acquire);
+            currentNode = AddressConverter::ExtractNode(currentTop);
+
+            if (!currentNode) {
+                return 0;
+            }
+
+            // 다른 스레드가 그 사이에 노드를 떼어 갔다면 아래 CAS가 실패하므로 따라간 next는 버려짐
+            lastNode = currentNode;
+            count = 1;
+            while (count < n && lastNode->next) {
+                lastNode = lastNode->next;
+                count++;
+            }
+
+            newTop = AddressConverter::AddStamp(lastNode->next, AddressConverter::NextStamp(currentTop));
+
+            if (CAS(&top, currentTop, newTop)) {
+                break;
+            }
+
+            backoff.Pause();
+        }
+
+        Node* node = currentNode;
+        for (size_t i = 0; i < count; i++) {
+            *out = std::move(node->data);
+            ++out;
+            node = node->next;
+        }
+
+        EpochReclaimer::Retire(currentNode, &DeleteChain, count);
+        return count;
+    }
+
+    // 꺼낸 값은 value로 옮겨짐 (move 대입)
     bool Pop(T& value) {
+        return PopWith([&value](T& data) { value = std::move(data); });
+    }
+
+    // 꺼낸 값을 옮겨 생성해서 반환. 비어 있다면 std::nullopt
+    // T가 기본 생성되지 않거나 move 대입이 없는 경우에 사용
+    std::optional<T> TryPop() {
+        std::optional<T> result;
+        PopWith([&result](T& data) { result.emplace(std::move(data)); });
+        return result;
+    }
+
+private:
+    // 해제하기 전에 consume(노드의 data)를 호출해서 값을 옮겨 가도록 함
+    // Pop한 노드는 다른 스레드가 next만 읽을 수 있고 data는 읽지 않으므로 CAS 직후 옮겨도 됨
+    template <typename Consume>
+    bool PopWith(Consume&& consume) {
         Node* currentNode;
         Node* nextNode = nullptr;
         UINT64 currentTop;
         UINT64 newTop;
-        UINT64 stValue = InterlockedIncrement(&stamp);
+        ExponentialBackoff backoff;
+
+        // top을 읽고 currentNode->next를 읽는 사이에 다른 스레드가 그 노드를 Pop해서 해제하지 못하도록 보호 구간에 들어감
+        EpochGuard guard;
 
         while (true) {
-            currentTop = top;
+            currentTop = top.load(std::memory_order_acquire);
             currentNode = AddressConverter::ExtractNode(currentTop);
 
             if (!currentNode) {
-                return false; //   
+                return false; // 스택이 비어 있음
             }
 
             nextNode = currentNode->next;
-            newTop = AddressConverter::AddStamp(nextNode, stValue);
+            newTop = AddressConverter::AddStamp(nextNode, AddressConverter::NextStamp(currentTop));
 
             if (CAS(&top, currentTop, newTop)) {
-                value = currentNode->data;
+                consume(currentNode->data);
+
+                // 바로 delete하지 않고, 지금 보호 구간에 있는 스레드가 모두 빠져나간 뒤에 해제
+                EpochReclaimer::Retire(currentNode, &DeleteNode);
+                return true; // 성공적으로 Pop 완료
+            }
 
-                delete currentNode;
-                return true; //  Pop Ϸ
+            // 경합 중이라면 동시에 Push하려는 스레드가 내놓은 노드를 직접 받아 봄
+            // 받은 노드는 스택에 들어간 적이 없어 다른 스레드가 읽지 않으므로 바로 해제
+            if (m_bUseElimination) {
+                Node* eliminated = m_elimination.TryPop();
+                if (eliminated) {
+                    consume(eliminated->data);
+                    DeleteNode(eliminated, 0);
+                    return true;
+                }
             }
+
+            backoff.Pause();
         }
     }
 
-private:
-    UINT64 top; // Top Ÿ tagged pointer
-    UINT64 stamp; //  Ǵ stamp 
+    // 노드 공간을 받아 생성. T의 생성자가 예외를 던지면 받은 공간을 돌려줌
+    template <typename... Args>
+    static Node* NewNode(Node* next, Args&&... args)
+    {
+        void* memory = Allocator::Allocate();
+        try {
+            return new (memory) Node(next, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            Allocator::Deallocate(memory);
+            throw;
+        }
+    }
+
+    bool m_bUseElimination;
+    alignas(CACHE_LINE_SIZE) std::atomic<UINT64> top; // Top을 나타내는 tagged pointer
+    EliminationArray<Node> m_elimination; // top CAS에 실패한 Push/Pop이 만나는 곳
 };
\ No newline at end of file
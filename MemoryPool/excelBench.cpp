@@ -286,6 +286,12 @@ void runProfiledBenchmark()
     std::wstring prefix = std::wstring(buf) + L"bytes, " +
         std::to_wstring(THREADS) + L"threads";
 
+    // 구간마다 이름을 만들지 않도록 태그를 미리 등록해 두고 ID로 측정
+    ProfileTagId newTag = ProfileRegisterTag(prefix + L" new      ");
+    ProfileTagId deleteTag = ProfileRegisterTag(prefix + L" delete   ");
+    ProfileTagId allocTag = ProfileRegisterTag(prefix + L" pool alloc");
+    ProfileTagId freeTag = ProfileRegisterTag(prefix + L" pool free ");
+
     // worker 쓰레드 함수
     auto worker = [&](int /*tid*/) {
         // TLS 풀 예열 (버킷당 1000개 노드)
@@ -294,7 +300,7 @@ void runProfiledBenchmark()
         for (int it = 0; it < phases; ++it) {
             // (1) new 할당 1000개
             {
-                Profile pf(prefix + L" new      ");
+                ProfileScope pf(newTag);
                 for (int i = 0; i < batch; ++i) {
                     Foo* p = new Foo();
                     (void)p;
@@ -303,7 +309,7 @@ void runProfiledBenchmark()
 
             // (2) delete 해제 1000개
             {
-                Profile pf(prefix + L" delete   ");
+                ProfileScope pf(deleteTag);
                 for (int i = 0; i < batch; ++i) {
                     // 실제로는 포인터를 저장했다가 delete 해야 하지만
                     // 여기선 예제를 단순화하기 위해 즉시 delete
@@ -313,7 +319,7 @@ void runProfiledBenchmark()
 
             // (3) pool 할당 1000개
             {
-                Profile pf(prefix + L" pool alloc");
+                ProfileScope pf(allocTag);
                 for (int i = 0; i < batch; ++i) {
                     Foo* p = tlsPool.Alloc();
                     (void)p;
@@ -322,7 +328,7 @@ void runProfiledBenchmark()
 
             // (4) pool 해제 1000개
             {
-                Profile pf(prefix + L" pool free ");
+                ProfileScope pf(freeTag);
                 for (int i = 0; i < batch; ++i) {
                     // 예제를 단순화하기 위해 Alloc→Free 쌍 보장
                     Foo* p = tlsPool.Alloc();
@@ -9,7 +9,7 @@
 
 #include <process.h>
 
-// ׽Ʈ Ŭ
+// 테스트용 클래스
 class TestObject
 {
 public:
@@ -27,7 +27,7 @@ private:
 };
 
 
-//  ׽Ʈ Լ
+// 성능 테스트용 함수
 void TestMemoryPoolPerformance(void)
 {
     ProfileReset();
@@ -35,13 +35,13 @@ void TestMemoryPoolPerformance(void)
     const size_t numObjects = 100000;
 
     //======================================================================
-    // ⺻ new/delete
+    // 기본 new/delete
     //======================================================================
 
-    //std::cout << "new/delete ׽Ʈ\n";
+    //std::cout << "new/delete 테스트\n";
 
     {
-        Profile pf(L"new/delete");
+        ProfileScope pf(PRO_TAG(L"new/delete"));
         for (size_t i = 0; i < numObjects; ++i)
         {
             TestObject* obj = new TestObject();
@@ -53,11 +53,11 @@ void TestMemoryPoolPerformance(void)
     // MemoryPool
     //======================================================================
 
-    //std::cout << "MemoryPool ׽Ʈ\n";
+    //std::cout << "MemoryPool 테스트\n";
 
     MemoryPool<TestObject, true> memoryPool(numObjects);
     {
-        Profile pf(L"MemoryPool");
+        ProfileScope pf(PRO_TAG(L"MemoryPool"));
         for (size_t i = 0; i < numObjects; ++i)
         {
             TestObject* obj = memoryPool.Alloc();
@@ -66,8 +66,9 @@ void TestMemoryPoolPerformance(void)
         }
     }
 
-    std::cout << "׽Ʈ Ϸ";
+    std::cout << "테스트 완료";
 
+    FlushThreadProfileData();
     ProfileDataOutText(L"profile_data.txt");
 }
 
@@ -157,7 +158,7 @@ unsigned int WINAPI Worker(void* pArg)
 
 
 
-// ڷ   TPS     1ʸ ϴ 
+// 인자로 받은 서버의 TPS 및 보고 싶은 정보를 1초마다 감시하는 스레드
 unsigned int WINAPI MonitorThread(void* pArg)
 {
     while (!bExitMonitor)
@@ -169,7 +170,7 @@ unsigned int WINAPI MonitorThread(void* pArg)
 
         std::cout << "===================================\n\n";
 
-        // 1ʰ Sleep
+        // 1초간 Sleep
         Sleep(1000);
     }
 
@@ -191,7 +192,7 @@ int main()
         hHandle[i] = (HANDLE)_beginthreadex(NULL, 0, Worker, NULL, 0, NULL);
     }
 
-    //   
+    // 모니터 스레드 생성
     hHandle[0] = (HANDLE)_beginthreadex(NULL, 0, MonitorThread, NULL, 0, NULL);
 
     WCHAR ControlKey;
@@ -219,7 +220,7 @@ int main()
     std::cout << "MaxPoolCount : " << testPool.GetMaxPoolCount() << "\n";
 
     std::cout << "===================================\n\n";
-    std::cout << "μ " << "\n";
+    std::cout << "프로세스 종료" << "\n";
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+﻿
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <string>
+#include "MemoryPool.h"
+
+#define REPEAT_COUNT 200
+#define OBJECT_COUNT 2000
+
+struct Foo {
+    int x[128];
+};
+
+// 노드마다 같은 수의 스레드를 두고, 스레드는 자신의 노드에 고정
+// bCrossNodeFree면 할당한 객체를 다른 노드의 스레드가 반환하는 경우를 섞음. 반환된 객체는 슬랩을 만든 노드의 샤드로 돌아가야 함
+void RunWorkload(MemoryPool<Foo, false>& pool, UINT32 nodeCount, int threadsPerNode, bool bCrossNodeFree)
+{
+    std::vector<std::vector<Foo*>> handoff(nodeCount * threadsPerNode);
+
+    auto worker = [&](UINT32 node, int index) {
+        NumaTopology::SetThreadNode(node);
+
+        std::vector<Foo*> v;
+        v.reserve(OBJECT_COUNT);
+
+        for (int k = 0; k < REPEAT_COUNT; ++k)
+        {
+            for (int i = 0; i < OBJECT_COUNT; ++i)
+            {
+                Foo* p = pool.Alloc();
+                p->x[0] = i;
+                v.push_back(p);
+            }
+
+            for (Foo* p : v)
+                pool.Free(p);
+            v.clear();
+        }
+
+        // 마지막 묶음은 다른 노드 스레드에게 넘김
+        if (bCrossNodeFree)
+        {
+            for (int i = 0; i < OBJECT_COUNT; ++i)
+                handoff[index].push_back(pool.Alloc());
+        }
+    };
+
+    std::vector<std::thread> ths;
+    for (UINT32 node = 0; node < nodeCount; ++node)
+        for (int t = 0; t < threadsPerNode; ++t)
+            ths.emplace_back(worker, node, static_cast<int>(node * threadsPerNode + t));
+    for (auto& th : ths) th.join();
+
+    // 넘겨받은 객체를 다음 노드의 스레드가 반환. 원래 노드의 샤드로 돌아가므로 원래 노드는 다음 Alloc에서도 hit
+    if (bCrossNodeFree)
+    {
+        ths.clear();
+        for (UINT32 node = 0; node < nodeCount; ++node)
+        {
+            ths.emplace_back([&, node]() {
+                NumaTopology::SetThreadNode((node + 1) % nodeCount);
+                for (int t = 0; t < threadsPerNode; ++t)
+                    for (Foo* p : handoff[node * threadsPerNode + t])
+                        pool.Free(p);
+            });
+        }
+        for (auto& th : ths) th.join();
+
+        ths.clear();
+        for (UINT32 node = 0; node < nodeCount; ++node)
+            ths.emplace_back(worker, node, 0);
+        for (auto& th : ths) th.join();
+    }
+}
+
+void testPool(const char* name, bool bNumaAware, UINT32 nodeCount, int threadsPerNode, bool bCrossNodeFree)
+{
+    // 매거진을 끄고 공유 free list를 직접 쓰도록 해서 샤드 동작이 그대로 보이게 함
+    MemoryPool<Foo, false> pool(0, 0, false, nullptr, bNumaAware);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    RunWorkload(pool, nodeCount, threadsPerNode, bCrossNodeFree);
+    auto end = std::chrono::high_resolution_clock::now();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    std::cout << "[" << name << (bCrossNodeFree ? ", cross-node free" : "") << "] " << ms << " ms, slabs nodes " << pool.GetMaxPoolCount() << "\n";
+    for (UINT32 shard = 0; shard < pool.GetNumaShardCount(); ++shard)
+    {
+        std::cout << "    shard " << shard << " : hit " << pool.GetShardHitCount(shard) << ", steal " << pool.GetShardStealCount(shard) << "\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // 실제 노드가 하나뿐이라면 시뮬레이션 토폴로지를 사용. 인자로 노드 수를 지정하면 항상 시뮬레이션
+    if (argc > 1)
+        NumaTopology::SetSimulatedNodeCount(static_cast<UINT32>(std::stoul(argv[1])));
+    else if (NumaTopology::GetNodeCount() == 1)
+        NumaTopology::SetSimulatedNodeCount(2);
+
+    UINT32 nodeCount = NumaTopology::GetNodeCount();
+    std::cout << "--- NUMA nodes : " << nodeCount << (NumaTopology::IsSimulated() ? " (simulated)" : "") << " ---\n";
+
+    for (int threadsPerNode : {1, 2, 4})
+    {
+        std::cout << "\n--- " << threadsPerNode << " threads per node ---\n";
+        testPool("single free list", false, nodeCount, threadsPerNode, false);
+        testPool("numa shards", true, nodeCount, threadsPerNode, false);
+    }
+
+    std::cout << "\n";
+    testPool("numa shards", true, nodeCount, 2, true);
+
+    return 0;
+}
@@ -0,0 +1,228 @@
+// 스레드 간 전달 큐 처리량 비교
+// MPMCQueue (lock-free), mutex + std::queue, CircularQueue (기존 디버그 기록용 링)
+// 생산자 N개, 소비자 N개가 원소를 주고받고 1, 2, 4, 8 쌍에서 초당 전달 수를 측정하며, 꺼낸 값의 합으로 누락/중복을 확인
+// CircularQueue는 꺼내는 쪽이 단일 스레드 디버그 전용이므로 생산자만 돌려 enqueue 처리량만 잼
+// 마지막으로 생산자 1개, 소비자 1개에서 SPSCQueue (하나씩, 묶음 단위)를 MPMCQueue, mutex + std::queue와 비교
+// 사용법 : queueBench [생산자당 원소 수]
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <mutex>
+#include <queue>
+#include <atomic>
+#include "MPMCQueue.h"
+#include "SPSCQueue.h"
+#include "CircularQueue.h"
+
+#define DEFAULT_ITEM_COUNT 200000
+#define QUEUE_CAPACITY 1024
+#define SPSC_BATCH_COUNT 64
+
+// 가득 찼거나 비었을 때 다른 스레드에게 CPU를 넘기고 다시 시도
+struct LockFreeAdapter
+{
+    MPMCQueue<UINT64> queue{ QUEUE_CAPACITY };
+
+    void Push(UINT64 value)
+    {
+        while (!queue.try_enqueue(value))
+            std::this_thread::yield();
+    }
+
+    bool TryPop(UINT64& value) { return queue.try_dequeue(value); }
+};
+
+// 크기 제한 없이 락 하나로 보호하는 std::queue
+struct MutexAdapter
+{
+    std::mutex lock;
+    std::queue<UINT64> queue;
+
+    void Push(UINT64 value)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        queue.push(value);
+    }
+
+    bool TryPop(UINT64& value)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (queue.empty())
+            return false;
+        value = queue.front();
+        queue.pop();
+        return true;
+    }
+};
+
+template <typename Adapter>
+double RunPair(int pairCount, int itemCount, bool& bOk)
+{
+    Adapter adapter;
+    std::atomic<UINT64> consumedSum{ 0 };
+    std::atomic<UINT64> consumedCount{ 0 };
+    const UINT64 totalCount = static_cast<UINT64>(pairCount) * itemCount;
+
+    auto producer = [&](int index) {
+        for (int i = 0; i < itemCount; ++i)
+            adapter.Push(static_cast<UINT64>(index) * itemCount + i + 1);
+    };
+
+    auto consumer = [&]() {
+        UINT64 value;
+        UINT64 sum = 0;
+        while (consumedCount.load(std::memory_order_relaxed) < totalCount)
+        {
+            if (adapter.TryPop(value))
+            {
+                sum += value;
+                consumedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        consumedSum.fetch_add(sum, std::memory_order_relaxed);
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> ths;
+    for (int t = 0; t < pairCount; ++t)
+    {
+        ths.emplace_back(producer, t);
+        ths.emplace_back(consumer);
+    }
+    for (auto& th : ths) th.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // 1부터 totalCount까지의 합과 같아야 함
+    bOk = bOk && consumedSum.load() == totalCount * (totalCount + 1) / 2;
+    return totalCount / seconds / 1e6;
+}
+
+// SPSCQueue 생산자 1개, 소비자 1개. batchCount가 1보다 크면 묶음 단위로 넣고 꺼냄
+double RunSPSC(int itemCount, size_t batchCount, bool& bOk)
+{
+    SPSCQueue<UINT64> queue(QUEUE_CAPACITY);
+    UINT64 consumedSum = 0;
+
+    auto producer = [&]() {
+        std::vector<UINT64> batch(batchCount);
+        UINT64 next = 1;
+        while (next <= static_cast<UINT64>(itemCount))
+        {
+            if (batchCount == 1)
+            {
+                if (queue.try_enqueue(next))
+                    next++;
+                else
+                    std::this_thread::yield();
+                continue;
+            }
+
+            // 아직 넣지 못한 값은 다음 시도에 다시 채워서 넣음
+            size_t count = 0;
+            for (UINT64 v = next; count < batchCount && v <= static_cast<UINT64>(itemCount); ++v)
+                batch[count++] = v;
+
+            size_t pushed = queue.try_enqueue_bulk(batch.begin(), count);
+            next += pushed;
+            if (pushed == 0)
+                std::this_thread::yield();
+        }
+    };
+
+    auto consumer = [&]() {
+        std::vector<UINT64> batch(batchCount);
+        UINT64 consumed = 0;
+        while (consumed < static_cast<UINT64>(itemCount))
+        {
+            size_t count;
+            if (batchCount == 1)
+                count = queue.try_dequeue(batch[0]) ? 1 : 0;
+            else
+                count = queue.try_dequeue_bulk(batch.begin(), batchCount);
+
+            if (count == 0)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            for (size_t i = 0; i < count; ++i)
+                consumedSum += batch[i];
+            consumed += count;
+        }
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+
+    std::thread producerThread(producer);
+    std::thread consumerThread(consumer);
+    producerThread.join();
+    consumerThread.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    UINT64 totalCount = static_cast<UINT64>(itemCount);
+    bOk = bOk && consumedSum == totalCount * (totalCount + 1) / 2;
+    return totalCount / seconds / 1e6;
+}
+
+double RunCircularEnqueue(int pairCount, int itemCount)
+{
+    // T queue[CQSIZE]를 그대로 품고 있어 스택에 두기에는 크므로 힙에 생성
+    CircularQueue<UINT64>* queue = new CircularQueue<UINT64>;
+
+    auto producer = [&](int index) {
+        for (int i = 0; i < itemCount; ++i)
+            queue->enqueue(static_cast<UINT64>(index) * itemCount + i + 1);
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> ths;
+    for (int t = 0; t < pairCount; ++t)
+        ths.emplace_back(producer, t);
+    for (auto& th : ths) th.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    delete queue;
+    return static_cast<double>(pairCount) * itemCount / seconds / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+    int itemCount = (argc > 1) ? std::stoi(argv[1]) : DEFAULT_ITEM_COUNT;
+    bool bOk = true;
+
+    std::cout << "pairs\tMPMCQueue (M/s)\tmutex+std::queue (M/s)\tspeedup\tCircularQueue enqueue only (M/s)\n";
+    for (int pairs : { 1, 2, 4, 8 })
+    {
+        double lockFree = RunPair<LockFreeAdapter>(pairs, itemCount, bOk);
+        double mutex = RunPair<MutexAdapter>(pairs, itemCount, bOk);
+        double circular = RunCircularEnqueue(pairs, itemCount);
+
+        std::cout << pairs << "\t" << std::fixed << std::setprecision(2)
+            << lockFree << "\t\t" << mutex << "\t\t\t" << lockFree / mutex << "x\t" << circular << "\n";
+    }
+
+    // 1:1 전달. 생산자와 소비자를 서로 다른 코어에 두어야 캐시 라인 분리 효과가 드러남
+    int spscItemCount = itemCount * 8;
+    std::cout << "\n1 producer / 1 consumer (M/s)\n";
+    std::cout << "SPSCQueue\t" << std::fixed << std::setprecision(2) << RunSPSC(spscItemCount, 1, bOk) << "\n";
+    std::cout << "SPSCQueue x" << SPSC_BATCH_COUNT << "\t" << RunSPSC(spscItemCount, SPSC_BATCH_COUNT, bOk) << "\n";
+    std::cout << "MPMCQueue\t" << RunPair<LockFreeAdapter>(1, spscItemCount, bOk) << "\n";
+    std::cout << "mutex+std::queue\t" << RunPair<MutexAdapter>(1, spscItemCount, bOk) << "\n";
+
+    std::cout << (bOk ? "checksum OK\n" : "checksum MISMATCH\n");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,287 @@
+// EpochReclaimer 스트레스 드라이버
+// 1) LockFreeStack : 여러 스레드가 Push/Pop하고, Pop한 노드는 EpochReclaimer를 거쳐 delete
+//    다른 스레드가 아직 next를 읽고 있는 노드를 delete하면 AddressSanitizer 빌드에서 heap-use-after-free로 멈춤
+// 2) MemoryPool : 매거진 없이 Alloc/Free하는 스레드와 Trim(0)을 반복하는 스레드를 함께 돌림
+//    반환된 슬랩은 munmap되므로 보호 구간이 틀렸다면 늦게 따라온 Pop이 SIGSEGV로 멈춤
+// 3) MemoryPool : 쓰는 양보다 넉넉히 채워 둔 풀에서 Alloc/Free하는 동안 Trim(keep)을 반복
+//    free list가 비는 일이 없으므로 Trim이 free list를 떼어간 사이 Alloc이 슬랩을 새로 만들면 GetMaxPoolCount가 처음보다 커짐
+// 4) EpochReclaimer : deleter 안에서 다시 Retire (Free -> Trim -> Retire 경로와 같은 모양)
+//    안쪽 Retire가 Collect까지 이어져도 각 항목의 deleter가 정확히 한 번씩 불려야 함
+// 끝까지 돌고 값의 합과 갯수가 맞으면 0을 반환
+// 사용법 : reclaimStress [스레드 수] [반복 횟수]
+
+// -DMEMORYPOOL_EPOCH_RECLAIM 로 이미 켠 빌드에서 재정의 경고가 나지 않도록 확인
+#ifndef MEMORYPOOL_EPOCH_RECLAIM
+#define MEMORYPOOL_EPOCH_RECLAIM
+#endif // MEMORYPOOL_EPOCH_RECLAIM
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include "MemoryPool.h"
+#include "concurrent_stack.h"
+
+#define DEFAULT_THREAD_COUNT 8
+#define DEFAULT_REPEAT_COUNT 200
+#define OBJECT_COUNT 1000
+
+struct Foo {
+    UINT64 value;
+    char payload[248];
+};
+
+bool RunStackStress(int threadCount, int repeatCount)
+{
+    LockFreeStack<UINT64> stack;
+    std::atomic<UINT64> pushedSum{ 0 };
+    std::atomic<UINT64> poppedSum{ 0 };
+
+    auto worker = [&](int index) {
+        UINT64 localPushed = 0;
+        UINT64 localPopped = 0;
+
+        for (int k = 0; k < repeatCount; ++k)
+        {
+            for (int i = 0; i < OBJECT_COUNT; ++i)
+            {
+                UINT64 value = static_cast<UINT64>(index) * OBJECT_COUNT + i + 1;
+                stack.Push(value);
+                localPushed += value;
+            }
+
+            // 다른 스레드가 넣은 값도 섞여서 나옴
+            UINT64 value = 0;
+            for (int i = 0; i < OBJECT_COUNT; ++i)
+            {
+                if (stack.Pop(value))
+                    localPopped += value;
+            }
+        }
+
+        pushedSum.fetch_add(localPushed);
+        poppedSum.fetch_add(localPopped);
+
+        EpochReclaimer::Drain();
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> ths;
+    for (int t = 0; t < threadCount; ++t)
+        ths.emplace_back(worker, t);
+    for (auto& th : ths) th.join();
+
+    // 남은 값도 꺼내서 합에 포함
+    UINT64 value;
+    UINT64 remainSum = 0;
+    while (stack.Pop(value))
+        remainSum += value;
+    EpochReclaimer::Drain();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+
+    bool bOk = (pushedSum.load() == poppedSum.load() + remainSum);
+    std::cout << "[LockFreeStack] " << threadCount << " threads, " << elapsed << " ms, "
+        << "retired " << EpochReclaimer::GetRetiredCount() << ", reclaimed " << EpochReclaimer::GetReclaimedCount()
+        << ", epoch " << EpochReclaimer::GetEpoch() << (bOk ? " : OK" : " : SUM MISMATCH") << "\n";
+    return bOk;
+}
+
+bool RunPoolTrimStress(int threadCount, int repeatCount)
+{
+    // 매거진을 끄면 모든 Alloc이 공유 free list에서 Pop하므로 Trim과 가장 많이 겹침
+    MemoryPool<Foo, false> pool(0, 0, false);
+    std::atomic<bool> bStop{ false };
+    std::atomic<bool> bCorrupted{ false };
+    UINT64 trimCount = 0;
+
+    std::thread trimmer([&]() {
+        while (!bStop.load(std::memory_order_relaxed))
+        {
+            pool.Trim(0);
+            trimCount++;
+            EpochReclaimer::Collect();
+        }
+        EpochReclaimer::Drain();
+    });
+
+    auto worker = [&](int index) {
+        std::vector<Foo*> v;
+        v.reserve(OBJECT_COUNT);
+
+        for (int k = 0; k < repeatCount; ++k)
+        {
+            for (int i = 0; i < OBJECT_COUNT; ++i)
+            {
+                Foo* p = pool.Alloc();
+                p->value = static_cast<UINT64>(index) << 32 | i;
+                v.push_back(p);
+            }
+
+            // 다른 스레드가 같은 객체를 받았다면 값이 바뀌어 있음
+            for (int i = 0; i < OBJECT_COUNT; ++i)
+            {
+                if (v[i]->value != (static_cast<UINT64>(index) << 32 | i))
+                    bCorrupted.store(true);
+                pool.Free(v[i]);
+            }
+            v.clear();
+        }
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> ths;
+    for (int t = 0; t < threadCount; ++t)
+        ths.emplace_back(worker, t);
+    for (auto& th : ths) th.join();
+
+    bStop.store(true);
+    trimmer.join();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+
+    bool bOk = !bCorrupted.load() && pool.GetCurPoolCount() == pool.GetMaxPoolCount();
+    std::cout << "[MemoryPool + Trim] " << threadCount << " threads, " << elapsed << " ms, "
+        << "trim " << trimCount << " times, unmapped " << pool.GetReclaimedBytes() / 1024 << " KB, "
+        << "cur " << pool.GetCurPoolCount() << " / max " << pool.GetMaxPoolCount() << (bOk ? " : OK" : " : CORRUPTED") << "\n";
+    return bOk;
+}
+
+bool RunTrimGrowthStress(int threadCount, int repeatCount)
+{
+    // 스레드마다 최대 OBJECT_COUNT개를 쓰므로, 그 두 배를 채워 두고 Trim은 쓰는 양만큼 남기게 하면 free list는 비지 않음
+    size_t liveMax = static_cast<size_t>(threadCount) * OBJECT_COUNT;
+    MemoryPool<Foo, false> pool(static_cast<UINT32>(liveMax * 2), 0, false);
+    UINT32 initialMax = pool.GetMaxPoolCount();
+    std::atomic<UINT32> peakMax{ initialMax };
+    std::atomic<bool> bStop{ false };
+    UINT64 trimCount = 0;
+
+    std::thread trimmer([&]() {
+        while (!bStop.load(std::memory_order_relaxed))
+        {
+            pool.Trim(liveMax);
+            trimCount++;
+            EpochReclaimer::Collect();
+        }
+        EpochReclaimer::Drain();
+    });
+
+    auto worker = [&](int index) {
+        std::vector<Foo*> v;
+        v.reserve(OBJECT_COUNT);
+
+        for (int k = 0; k < repeatCount; ++k)
+        {
+            for (int i = 0; i < OBJECT_COUNT; ++i)
+            {
+                Foo* p = pool.Alloc();
+                p->value = static_cast<UINT64>(index) << 32 | i;
+                v.push_back(p);
+            }
+
+            // 가장 많이 쓰고 있는 시점의 최대 노드 수를 기록
+            UINT32 currentMax = pool.GetMaxPoolCount();
+            UINT32 peak = peakMax.load(std::memory_order_relaxed);
+            while (currentMax > peak && !peakMax.compare_exchange_weak(peak, currentMax))
+            {
+            }
+
+            for (Foo* p : v)
+                pool.Free(p);
+            v.clear();
+        }
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> ths;
+    for (int t = 0; t < threadCount; ++t)
+        ths.emplace_back(worker, t);
+    for (auto& th : ths) th.join();
+
+    bStop.store(true);
+    trimmer.join();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+
+    bool bOk = peakMax.load() <= initialMax && pool.GetCurPoolCount() == pool.GetMaxPoolCount();
+    std::cout << "[MemoryPool Trim vs Alloc] " << threadCount << " threads, " << elapsed << " ms, "
+        << "trim " << trimCount << " times, max " << initialMax << " -> peak " << peakMax.load()
+        << (bOk ? " : OK" : " : POOL GREW DURING TRIM") << "\n";
+    return bOk;
+}
+
+// deleter가 불린 횟수를 세고, 딸린 항목이 있다면 deleter 안에서 Retire
+struct NestedRetireItem {
+    std::atomic<UINT32> freeCount{ 0 };
+    NestedRetireItem* child = nullptr;
+};
+
+void NestedRetireDeleter(void* ptr, size_t)
+{
+    NestedRetireItem* item = static_cast<NestedRetireItem*>(ptr);
+    item->freeCount.fetch_add(1, std::memory_order_relaxed);
+    if (item->child)
+        EpochReclaimer::Retire(item->child, NestedRetireDeleter);
+}
+
+bool RunNestedRetireStress(int threadCount, int repeatCount)
+{
+    std::atomic<bool> bWrongCount{ false };
+
+    auto worker = [&]() {
+        // 절반은 deleter에서 딸린 항목을 Retire하므로 안쪽 Retire도 EPOCH_COLLECT_PERIOD에 자주 걸림
+        std::vector<NestedRetireItem> items(OBJECT_COUNT * 2);
+
+        for (int k = 0; k < repeatCount; ++k)
+        {
+            for (auto& item : items)
+                item.freeCount.store(0, std::memory_order_relaxed);
+            for (int i = 0; i < OBJECT_COUNT; ++i)
+                items[i].child = &items[OBJECT_COUNT + i];
+
+            for (int i = 0; i < OBJECT_COUNT; ++i)
+                EpochReclaimer::Retire(&items[i], NestedRetireDeleter);
+            EpochReclaimer::Drain();
+
+            // 두 번 불렸다면 이중 해제, 안 불렸다면 목록에서 잘못 지워져 새어 나간 것
+            for (auto& item : items)
+            {
+                if (item.freeCount.load(std::memory_order_relaxed) != 1)
+                    bWrongCount.store(true);
+            }
+        }
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> ths;
+    for (int t = 0; t < threadCount; ++t)
+        ths.emplace_back(worker);
+    for (auto& th : ths) th.join();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+
+    bool bOk = !bWrongCount.load();
+    std::cout << "[EpochReclaimer nested Retire] " << threadCount << " threads, " << elapsed << " ms"
+        << (bOk ? " : OK" : " : DELETER CALLED TWICE OR NEVER") << "\n";
+    return bOk;
+}
+
+int main(int argc, char* argv[])
+{
+    int threadCount = (argc > 1) ? std::stoi(argv[1]) : DEFAULT_THREAD_COUNT;
+    int repeatCount = (argc > 2) ? std::stoi(argv[2]) : DEFAULT_REPEAT_COUNT;
+
+    bool bOk = RunStackStress(threadCount, repeatCount);
+    bOk = RunPoolTrimStress(threadCount, repeatCount) && bOk;
+    bOk = RunTrimGrowthStress(threadCount, repeatCount) && bOk;
+    bOk = RunNestedRetireStress(threadCount, repeatCount) && bOk;
+
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include "SizeClassPool.h"
+
+// excelBench 의 4 ~ 8192 바이트 스윕을 SizeClassPool 까지 넣어서 돌림
+// new/delete, 크기마다 타입을 따로 둔 tlsMemoryPool, 크기만 넘기는 SizeClassPool 을 비교
+
+#define PER_THREAD_COUNT 20000
+#define REPEAT_COUNT 10
+
+// 풀은 최대로 쓴 만큼 들고 있으므로, 큰 크기에서는 스레드당 살아 있는 메모리를 이만큼으로 제한하고 반복을 늘려 연산 수를 맞춤
+#define PER_THREAD_BYTES (8 * 1024 * 1024)
+
+// 런타임 크기별 구조체. tlsMemoryPool 은 타입이 필요하므로 크기마다 하나씩
+template <size_t N>
+struct TestStruct {
+    alignas(std::max_align_t) char data[N];
+};
+
+// 스레드마다 count 개를 할당하고 모두 해제하는 것을 반복한 전체 시간 (ms). 스레드당 연산 수는 크기와 관계없이 같음
+template <typename Body>
+double runInThreads(int threads, size_t count, Body body)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> ths;
+    ths.reserve(threads);
+    for (int t = 0; t < threads; ++t)
+    {
+        ths.emplace_back([&body, count]() {
+            std::vector<void*> ptrs(count);
+            size_t repeat = static_cast<size_t>(REPEAT_COUNT) * PER_THREAD_COUNT / count;
+            for (size_t r = 0; r < repeat; ++r)
+            {
+                body(ptrs);
+            }
+            });
+    }
+    for (auto& th : ths) th.join();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+template <size_t N>
+void runBenchmark(int threads, std::ofstream& csv)
+{
+    using Foo = TestStruct<N>;
+    constexpr size_t count = (PER_THREAD_COUNT * N > PER_THREAD_BYTES) ? PER_THREAD_BYTES / N : PER_THREAD_COUNT;
+
+    double newMs = runInThreads(threads, count, [](std::vector<void*>& ptrs) {
+        for (auto& p : ptrs) p = new Foo();
+        for (void* p : ptrs) delete static_cast<Foo*>(p);
+        });
+
+    double tlsMs = runInThreads(threads, count, [](std::vector<void*>& ptrs) {
+        static tlsMemoryPool<Foo, false> pool;
+        for (auto& p : ptrs) p = pool.Alloc();
+        for (void* p : ptrs) pool.Free(static_cast<Foo*>(p));
+        });
+
+    double sizeClassMs = runInThreads(threads, count, [](std::vector<void*>& ptrs) {
+        SizeClassPool& pool = SizeClassPool::GetDefault();
+        for (auto& p : ptrs) p = pool.Allocate(N);
+        for (void* p : ptrs) pool.Deallocate(p, N);
+        });
+
+    std::cout
+        << N << " bytes, " << threads << " threads : "
+        << "new=" << newMs << " ms, "
+        << "tlsMemoryPool=" << tlsMs << " ms, "
+        << "SizeClassPool=" << sizeClassMs << " ms\n";
+
+    csv << N << ',' << threads << ',' << newMs << ',' << tlsMs << ',' << sizeClassMs << '\n';
+}
+
+int main()
+{
+    std::vector<int> threadsL = { 1,2,4,8,16 };
+
+    std::ofstream csv("size_class_results.csv");
+    if (!csv) {
+        std::cerr << "CSV 파일 열기 실패\n";
+        return 1;
+    }
+    csv << "size,threads,new_ms,tls_pool_ms,size_class_ms\n";
+
+    for (int th : threadsL)
+    {
+        runBenchmark<4>(th, csv);
+        runBenchmark<16>(th, csv);
+        runBenchmark<64>(th, csv);
+        runBenchmark<256>(th, csv);
+        runBenchmark<1024>(th, csv);
+        runBenchmark<4096>(th, csv);
+        runBenchmark<8192>(th, csv);
+    }
+
+    csv.close();
+    std::cout << "\nCSV 저장 완료: size_class_results.csv\n";
+    return 0;
+}
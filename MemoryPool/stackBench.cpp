@@ -0,0 +1,69 @@
+// LockFreeStack 노드 할당 정책별, 제거 배열(elimination backoff) 사용 여부별 처리량 비교
+// 스레드마다 Push 한 묶음, Pop 한 묶음을 반복하고 1, 2, 4, 8, 16 스레드에서 초당 연산 수를 측정
+// 사용법 : stackBench [스레드당 반복 횟수]
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <string>
+#include "concurrent_stack.h"
+
+#define DEFAULT_REPEAT_COUNT 200
+#define BATCH_COUNT 256
+
+template <template <typename> class NodeAllocator>
+double RunStack(int threadCount, int repeatCount, bool bUseElimination)
+{
+    LockFreeStack<UINT64, NodeAllocator> stack(bUseElimination);
+
+    auto worker = [&](int index) {
+        UINT64 value;
+        for (int k = 0; k < repeatCount; ++k)
+        {
+            for (int i = 0; i < BATCH_COUNT; ++i)
+                stack.Push(static_cast<UINT64>(index) * BATCH_COUNT + i);
+
+            for (int i = 0; i < BATCH_COUNT; ++i)
+                stack.Pop(value);
+        }
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> ths;
+    for (int t = 0; t < threadCount; ++t)
+        ths.emplace_back(worker, t);
+    for (auto& th : ths) th.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // Push + Pop을 각각 연산 하나로 셈
+    double ops = 2.0 * threadCount * repeatCount * BATCH_COUNT;
+    return ops / seconds / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+    int repeatCount = (argc > 1) ? std::stoi(argv[1]) : DEFAULT_REPEAT_COUNT;
+
+    // 처음 한 번은 풀과 EpochReclaimer 레코드를 만드는 비용이 섞이므로 버림
+    RunStack<PoolNodeAllocator>(1, 1, false);
+    RunStack<NewDeleteNodeAllocator>(1, 1, false);
+
+    // 앞의 두 열은 제거 배열 없이 할당 정책만 비교, 마지막 열은 MemoryPool 정책에 제거 배열을 켠 결과
+    std::cout << "threads\tnew/delete (Mops/s)\tMemoryPool (Mops/s)\tspeedup\tMemoryPool+elimination (Mops/s)\n";
+    for (int threads : { 1, 2, 4, 8, 16 })
+    {
+        double newDelete = RunStack<NewDeleteNodeAllocator>(threads, repeatCount, false);
+        double pool = RunStack<PoolNodeAllocator>(threads, repeatCount, false);
+        double elimination = RunStack<PoolNodeAllocator>(threads, repeatCount, true);
+
+        std::cout << threads << "\t" << std::fixed << std::setprecision(2)
+            << newDelete << "\t\t\t" << pool << "\t\t\t" << pool / newDelete << "x\t"
+            << elimination << "\n";
+    }
+
+    return 0;
+}
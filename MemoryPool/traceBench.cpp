@@ -0,0 +1,92 @@
+// PoolTrace 이벤트 기록 비용 측정
+// 1) PoolTrace::Record 만 반복해서 이벤트 하나당 비용
+// 2) MemoryPool Alloc/Free 를 기록을 끈 상태와 켠 상태로 돌려서 늘어난 시간
+// 끝나면 pool_trace.bin 으로 덤프하므로 traceDecode pool_trace.bin 으로 확인
+// 사용법 : traceBench [--inject-double-free]
+//   --inject-double-free : 같은 객체를 두 번 Free해서 traceDecode --check 가 잡아내는지 확인하는 용도
+
+// -DMEMORYPOOL_TRACE 로 이미 켠 빌드에서 재정의 경고가 나지 않도록 확인
+#ifndef MEMORYPOOL_TRACE
+#define MEMORYPOOL_TRACE
+#endif // MEMORYPOOL_TRACE
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include "MemoryPool.h"
+
+#define RECORD_COUNT 10000000
+#define REPEAT_COUNT 200
+#define OBJECT_COUNT 10000
+
+struct Foo {
+    UINT64 x[4];
+};
+
+double NsPerRecord(void)
+{
+    int dummy = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < RECORD_COUNT; ++i)
+        PoolTrace::Record(PoolTraceEvent::Alloc, &dummy, &dummy + i, i);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return seconds * 1e9 / RECORD_COUNT;
+}
+
+// Alloc/Free 한 쌍(이벤트 2개)당 ns
+double NsPerPair(MemoryPool<Foo, false>& pool)
+{
+    std::vector<Foo*> v(OBJECT_COUNT);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int k = 0; k < REPEAT_COUNT; ++k)
+    {
+        for (int i = 0; i < OBJECT_COUNT; ++i)
+            v[i] = pool.Alloc();
+        for (int i = 0; i < OBJECT_COUNT; ++i)
+            pool.Free(v[i]);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return seconds * 1e9 / (static_cast<double>(REPEAT_COUNT) * OBJECT_COUNT);
+}
+
+int main(int argc, char* argv[])
+{
+    bool bInject = (argc > 1 && strcmp(argv[1], "--inject-double-free") == 0);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "PoolTrace::Record : " << NsPerRecord() << " ns/event\n";
+
+    MemoryPool<Foo, false> pool;
+    NsPerPair(pool); // 슬랩과 매거진을 미리 만들어 둠
+
+    PoolTrace::SetEnabled(false);
+    double off = NsPerPair(pool);
+    PoolTrace::SetEnabled(true);
+    double on = NsPerPair(pool);
+
+    std::cout << "Alloc+Free, trace off : " << off << " ns/pair\n";
+    std::cout << "Alloc+Free, trace on  : " << on << " ns/pair (+" << (on - off) / 2 << " ns/event)\n";
+
+    if (bInject)
+    {
+        // 같은 객체를 두 번 반환하면 매거진에 두 번 들어가고, 다음 Alloc 두 번이 같은 주소를 돌려줌
+        Foo* p = pool.Alloc();
+        pool.Free(p);
+        pool.Free(p);
+        Foo* a = pool.Alloc();
+        Foo* b = pool.Alloc();
+        std::cout << "injected double free : " << p << " -> " << a << ", " << b << "\n";
+    }
+
+    if (!PoolTrace::Dump("pool_trace.bin"))
+    {
+        std::cerr << "dump failed\n";
+        return 1;
+    }
+    std::cout << "dumped to pool_trace.bin (" << PoolTrace::GetTicksPerSecond() / 1000000 << " M ticks/s)\n";
+    return 0;
+}
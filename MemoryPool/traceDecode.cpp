@@ -0,0 +1,172 @@
+// PoolTrace::Dump 로 쓴 바이너리 덤프를 읽어 시간순으로 출력하고, 객체별 Alloc / Free 순서를 검사
+//   이중 해제 : 이미 반환된 객체를 다시 Free
+//   이중 할당 : 반환되지 않은 객체를 다시 Alloc (free list에 같은 노드가 두 번 들어갔거나 ABA로 꼬인 경우)
+// 사용법 : traceDecode <덤프 파일> [--check]
+//   --check : 이벤트 목록은 출력하지 않고 검사 결과만 출력. 문제가 있다면 종료 코드 1
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+#include "PoolTrace.h"
+
+struct DecodedEvent
+{
+    UINT64 threadId;
+    PoolTraceRecord record;
+};
+
+static const char* EventName(UINT16 event)
+{
+    switch (static_cast<PoolTraceEvent>(event))
+    {
+    case PoolTraceEvent::Alloc:         return "ALLOC";
+    case PoolTraceEvent::Free:          return "FREE";
+    case PoolTraceEvent::FreeRejected:  return "FREE_REJECTED";
+    case PoolTraceEvent::PushChain:     return "PUSH_CHAIN";
+    case PoolTraceEvent::PopChain:      return "POP_CHAIN";
+    case PoolTraceEvent::SlabAlloc:     return "SLAB_ALLOC";
+    case PoolTraceEvent::SlabRelease:   return "SLAB_RELEASE";
+    }
+    return "UNKNOWN";
+}
+
+static bool ReadFile(const char* fileName, PoolTraceFileHeader& header, std::vector<DecodedEvent>& events, UINT64& windowStart)
+{
+    FILE* file = nullptr;
+#if defined(_MSC_VER)
+    if (fopen_s(&file, fileName, "rb") != 0)
+        file = nullptr;
+#else
+    file = fopen(fileName, "rb");
+#endif // _MSC_VER
+    if (file == nullptr)
+    {
+        std::cerr << "cannot open " << fileName << "\n";
+        return false;
+    }
+
+    bool bOk = fread(&header, sizeof(header), 1, file) == 1
+        && memcmp(header.magic, POOL_TRACE_MAGIC, sizeof(POOL_TRACE_MAGIC)) == 0
+        && header.version == POOL_TRACE_VERSION
+        && header.recordSize == sizeof(PoolTraceRecord);
+    if (!bOk)
+    {
+        std::cerr << "not a pool trace dump (or unsupported version)\n";
+        fclose(file);
+        return false;
+    }
+
+    // 덮어써서 앞부분을 잃은 스레드가 있다면, 그 스레드의 가장 오래된 이벤트 이후만 모든 스레드의 기록이 온전함
+    windowStart = 0;
+
+    for (UINT32 r = 0; r < header.ringCount && bOk; r++)
+    {
+        PoolTraceRingHeader ringHeader;
+        bOk = fread(&ringHeader, sizeof(ringHeader), 1, file) == 1;
+        if (!bOk)
+            break;
+
+        std::vector<PoolTraceRecord> records(ringHeader.recordCount);
+        bOk = fread(records.data(), sizeof(PoolTraceRecord), records.size(), file) == records.size();
+
+        UINT64 lost = ringHeader.writeCount - ringHeader.recordCount;
+        std::cout << "thread " << ringHeader.threadId << " : " << ringHeader.writeCount << " events, "
+            << ringHeader.recordCount << " kept" << (lost ? ", " + std::to_string(lost) + " overwritten" : "") << "\n";
+
+        if (lost && !records.empty())
+            windowStart = std::max(windowStart, records.front().tsc);
+
+        for (const PoolTraceRecord& record : records)
+            events.push_back(DecodedEvent{ ringHeader.threadId, record });
+    }
+
+    fclose(file);
+    if (!bOk)
+        std::cerr << "truncated dump\n";
+    return bOk;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage : traceDecode <dump file> [--check]\n";
+        return 2;
+    }
+
+    bool bCheckOnly = (argc > 2 && strcmp(argv[2], "--check") == 0);
+
+    PoolTraceFileHeader header;
+    std::vector<DecodedEvent> events;
+    UINT64 windowStart;
+    if (!ReadFile(argv[1], header, events, windowStart))
+        return 2;
+
+    // 스레드별 링을 합쳐서 tsc 순서로 정렬 (코어 간 tsc가 동기화되어 있다고 가정)
+    std::stable_sort(events.begin(), events.end(), [](const DecodedEvent& a, const DecodedEvent& b) { return a.record.tsc < b.record.tsc; });
+
+    UINT64 baseTick = events.empty() ? 0 : events.front().record.tsc;
+    double nsPerTick = header.ticksPerSecond ? 1e9 / header.ticksPerSecond : 1.0;
+    auto timeNs = [&](UINT64 tsc) { return static_cast<UINT64>((tsc - baseTick) * nsPerTick); };
+
+    if (!bCheckOnly)
+    {
+        std::cout << "\ntime(ns)\tthread\tevent\tpool\tnode\taux\n";
+        for (const DecodedEvent& e : events)
+        {
+            std::cout << timeNs(e.record.tsc) << "\t" << e.threadId << "\t" << EventName(e.record.event)
+                << "\t0x" << std::hex << e.record.pool << "\t0x" << e.record.node << std::dec << "\t" << e.record.aux << "\n";
+        }
+    }
+
+    // 객체마다 마지막 Alloc / Free 이벤트를 들고 있다가 같은 종류가 연달아 나오면 보고
+    struct ObjectState
+    {
+        UINT16 lastEvent;
+        const DecodedEvent* last;
+    };
+    std::unordered_map<UINT64, ObjectState> objects;
+    size_t doubleFree = 0;
+    size_t doubleAlloc = 0;
+    size_t rejected = 0;
+
+    for (const DecodedEvent& e : events)
+    {
+        if (e.record.tsc < windowStart)
+            continue;
+
+        UINT16 event = e.record.event;
+        if (event == static_cast<UINT16>(PoolTraceEvent::FreeRejected))
+        {
+            rejected++;
+            continue;
+        }
+        if (event != static_cast<UINT16>(PoolTraceEvent::Alloc) && event != static_cast<UINT16>(PoolTraceEvent::Free))
+            continue;
+
+        // 풀마다 객체 주소가 겹치지 않으므로 주소만으로 구분하고, 풀이 다르다면 새 객체로 봄
+        auto it = objects.find(e.record.node);
+        if (it != objects.end() && it->second.last->record.pool == e.record.pool && it->second.lastEvent == event)
+        {
+            bool bFree = (event == static_cast<UINT16>(PoolTraceEvent::Free));
+            (bFree ? doubleFree : doubleAlloc)++;
+
+            std::cout << (bFree ? "DOUBLE FREE" : "DOUBLE ALLOC") << " node 0x" << std::hex << e.record.node << std::dec
+                << " : thread " << it->second.last->threadId << " at " << timeNs(it->second.last->record.tsc) << " ns"
+                << ", then thread " << e.threadId << " at " << timeNs(e.record.tsc) << " ns\n";
+        }
+
+        objects[e.record.node] = ObjectState{ event, &e };
+    }
+
+    std::cout << "\n" << events.size() << " events, " << objects.size() << " objects checked"
+        << (windowStart ? " (from the oldest complete point)" : "")
+        << " : double free " << doubleFree << ", double alloc " << doubleAlloc << ", rejected free " << rejected << "\n";
+
+    return (doubleFree || doubleAlloc) ? 1 : 0;
+}